@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Utils/LocalOpts.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/InstrTypes.h"
 // L'include seguente va in LocalOpts.h
@@ -118,7 +119,13 @@ bool runOnAlgebraicIdentity (BasicBlock &B) {
 }
 
 //funzione che implementa l'advanced strength reduction 
-bool runOnBasicBlockAdv(BasicBlock &B) {
+bool runOnBasicBlockAdv(BasicBlock &B, bool SpareRegister,
+                        function_ref<bool(Value *)> IsNonNegative) {
+    const DataLayout &DL = B.getModule()->getDataLayout();
+    auto NonNegative = [&](Value *V) {
+      return IsNonNegative ? IsNonNegative(V) : isKnownNonNegative(V, DL);
+    };
+
     for (auto &I : B) {
         if (Instruction::Mul == I.getOpcode()) {
 
@@ -152,7 +159,7 @@ bool runOnBasicBlockAdv(BasicBlock &B) {
 
                 NewI_1->insertAfter(&I);
                 I.replaceAllUsesWith(NewI_1);
-              } else if ((val+1).isPowerOf2()) {
+              } else if (SpareRegister && (val+1).isPowerOf2()) {
 
                 ConstantInt *shiftOp = ConstantInt::get(imm->getType(), imm->getValue().nearestLogBase2());
                 outs() << "[runOnBasicBlockAdv]: "<< I.getOpcodeName() << " ->"<< I << "\n";
@@ -172,7 +179,7 @@ bool runOnBasicBlockAdv(BasicBlock &B) {
                 NewI_1->insertAfter(&I);
                 NewI_2->insertAfter(NewI_1);
                 I.replaceAllUsesWith(NewI_2);
-            } else if ((val-1).isPowerOf2()) {
+            } else if (SpareRegister && (val-1).isPowerOf2()) {
 
                 ConstantInt *shiftOp = ConstantInt::get(imm->getType(), imm->getValue().nearestLogBase2());
                 outs() << "[runOnBasicBlockAdv]: "<< I.getOpcodeName() << " ->"<< I << "\n";
@@ -196,35 +203,31 @@ bool runOnBasicBlockAdv(BasicBlock &B) {
           }
         } else if (Instruction::SDiv == I.getOpcode()) {
 
-            bool swp = false;
-            ConstantInt *imm = nullptr;
+            // sdiv arrotonda verso zero: lshr e udiv danno lo stesso risultato
+            // solo con dividendo e divisore non negativi
+            Value *dividend = I.getOperand(0);
+            Value *divisor = I.getOperand(1);
 
-            if (ConstantInt *secOp = dyn_cast<ConstantInt>(I.getOperand(1))) {
-              imm = secOp;
-            }
-            else if (ConstantInt *firOp = dyn_cast<ConstantInt>(I.getOperand(0))) {
-                imm = firOp;
-                swp = true;
-            }
+            if (NonNegative(dividend) && NonNegative(divisor)) {
+              ConstantInt *imm = dyn_cast<ConstantInt>(divisor);
+              Instruction *NewI_1;
 
-            if (imm != nullptr) {
-              if (imm->getValue().isPowerOf2()) {
-                ConstantInt *shiftOp = ConstantInt::get(imm->getType(), imm->getValue().nearestLogBase2());
+              if (imm != nullptr && imm->getValue().isPowerOf2()) {
+                ConstantInt *shiftOp = ConstantInt::get(imm->getType(), imm->getValue().exactLogBase2());
                 outs() << "[runOnBasicBlockAdv]: "<< I.getOpcodeName() << " ->"<< I << "\n";
                 outs() << "Immediato potenza di 2 -> shift x>>" << shiftOp->getValue() <<"\n";
 
-                Instruction *NewI_1;
-
-                if (swp) {
-                  NewI_1 = BinaryOperator::Create(Instruction::LShr, I.getOperand(1), shiftOp);
-                } else {
-                  NewI_1 = BinaryOperator::Create(Instruction::LShr, I.getOperand(0), shiftOp);
-                }
-
-                NewI_1->insertAfter(&I);
-                I.replaceAllUsesWith(NewI_1);
+                NewI_1 = BinaryOperator::Create(Instruction::LShr, dividend, shiftOp);
+              } else {
+                outs() << "[runOnBasicBlockAdv]: "<< I.getOpcodeName() << " ->"<< I << "\n";
+                outs() << "Operandi non negativi -> udiv\n";
 
+                NewI_1 = BinaryOperator::Create(Instruction::UDiv, dividend, divisor);
               }
+
+              NewI_1->setIsExact(I.isExact());
+              NewI_1->insertAfter(&I);
+              I.replaceAllUsesWith(NewI_1);
             }
         }
     }
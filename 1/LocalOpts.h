@@ -2,6 +2,7 @@
 #define LLVM_TRANSFORMS_LOCALOPTS_H
 
 #include "llvm/IR/PassManager.h"
+#include "llvm/ADT/STLExtras.h"
 #include <llvm/IR/Constants.h>
 
 namespace llvm {
@@ -10,4 +11,15 @@ public:
 PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
 };
 } // namespace llvm
+
+// peephole sul singolo basic block, riutilizzabili da altri passi
+bool runOnAlgebraicIdentity(llvm::BasicBlock &B);
+// SpareRegister = false: nel blocco non c'è un registro libero per il
+// temporaneo delle sequenze shift+add/sub, che vengono evitate.
+// IsNonNegative: valori dimostrati non negativi (es. da un'analisi degli
+// intervalli) per convertire sdiv in lshr/udiv; di default ValueTracking
+bool runOnBasicBlockAdv(
+    llvm::BasicBlock &B, bool SpareRegister = true,
+    llvm::function_ref<bool(llvm::Value *)> IsNonNegative = nullptr);
+bool runOnMultiInstruction(llvm::BasicBlock &B);
 #endif // LLVM_TRANSFORMS_LOCALOPTS _H
@@ -0,0 +1,219 @@
+#include "llvm/Transforms/Utils/AggressiveDCE.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+using namespace llvm;
+
+// Marcatura delle istruzioni vive: si parte dalle istruzioni con effetti
+// collaterali e si risale lungo gli operandi (dipendenze sui dati) e lungo
+// i branch da cui dipende l'esecuzione dei blocchi vivi (dipendenze di
+// controllo)
+class DeadCodeMarker {
+public:
+  DeadCodeMarker(Function &F, PostDominatorTree &PDT);
+
+  void markRoots(LoopInfo &LI, ScalarEvolution &SE);
+  void propagate();
+
+  unsigned removeDeadBranches();
+  unsigned removeDeadInstructions();
+
+private:
+  void markLive(Instruction *I) {
+    if (Live.insert(I).second)
+      Worklist.push_back(I);
+  }
+
+  Function &F;
+  std::vector<BasicBlock *> Reachable;
+  // blocchi -> blocchi il cui branch decide se vengono eseguiti
+  DenseMap<const BasicBlock *, SmallVector<BasicBlock *, 2>> ControlDeps;
+  // numerazione post-order del CFG inverso a partire dalle uscite; 0 per i
+  // blocchi da cui non si raggiunge un'uscita
+  DenseMap<const BasicBlock *, unsigned> PostOrder;
+
+  DenseSet<Instruction *> Live;
+  DenseSet<const BasicBlock *> LiveBlocks;
+  SmallVector<Instruction *, 32> Worklist;
+};
+
+DeadCodeMarker::DeadCodeMarker(Function &F, PostDominatorTree &PDT) : F(F) {
+  for (BasicBlock *BB : depth_first(&F.getEntryBlock()))
+    Reachable.push_back(BB);
+
+  // B dipende dall'arco A -> S se post-domina S ma non post-domina
+  // strettamente A: sono i blocchi da S (incluso) a ipdom(A) (escluso)
+  for (BasicBlock *A : Reachable) {
+    DomTreeNode *Stop = PDT.getNode(A)->getIDom();
+    for (BasicBlock *S : successors(A))
+      for (DomTreeNode *N = PDT.getNode(S); N && N != Stop && N->getBlock();
+           N = N->getIDom()) {
+        auto &Deps = ControlDeps[N->getBlock()];
+        if (!is_contained(Deps, A))
+          Deps.push_back(A);
+      }
+  }
+
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  unsigned Num = 0;
+  for (BasicBlock *BB : Reachable) {
+    if (!succ_empty(BB))
+      continue;
+    for (BasicBlock *Block : inverse_post_order_ext(BB, Visited))
+      PostOrder[Block] = ++Num;
+  }
+}
+
+void DeadCodeMarker::markRoots(LoopInfo &LI, ScalarEvolution &SE) {
+  for (BasicBlock *BB : Reachable) {
+    // da questi blocchi non si esce (loop infiniti): i branch restano
+    if (!PostOrder.count(BB))
+      markLive(BB->getTerminator());
+
+    for (Instruction &I : *BB) {
+      if (isa<DbgInfoIntrinsic>(I))
+        continue;
+      if (I.isTerminator()) {
+        if (!isa<BranchInst>(I) && !isa<SwitchInst>(I))
+          markLive(&I);
+        continue;
+      }
+      if (!wouldInstructionBeTriviallyDead(&I))
+        markLive(&I);
+    }
+  }
+
+  // un loop senza effetti può essere rimosso solo se termina: trip count
+  // calcolabile o loop mustprogress. Per gli altri il back-edge resta vivo,
+  // e con esso i branch da cui dipende
+  SmallVector<std::pair<const BasicBlock *, const BasicBlock *>, 8> BackEdges;
+  FindFunctionBackedges(F, BackEdges);
+  for (auto &Edge : BackEdges) {
+    Loop *L = LI.getLoopFor(Edge.second);
+    bool Finite = L && L->getHeader() == Edge.second &&
+                  (isMustProgress(L) ||
+                   !isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(L)));
+    if (!Finite)
+      markLive(const_cast<BasicBlock *>(Edge.first)->getTerminator());
+  }
+}
+
+void DeadCodeMarker::propagate() {
+  while (!Worklist.empty()) {
+    Instruction *I = Worklist.pop_back_val();
+
+    if (LiveBlocks.insert(I->getParent()).second)
+      for (BasicBlock *Dep : ControlDeps.lookup(I->getParent()))
+        markLive(Dep->getTerminator());
+
+    for (Value *Op : I->operands())
+      if (auto *OpI = dyn_cast<Instruction>(Op))
+        markLive(OpI);
+
+    // il valore di una PHI dipende dal cammino: contano i branch dei
+    // predecessori
+    if (auto *PN = dyn_cast<PHINode>(I))
+      for (BasicBlock *Pred : PN->blocks())
+        markLive(Pred->getTerminator());
+  }
+}
+
+// Un branch morto diventa incondizionato verso il successore più vicino
+// all'uscita (numero post-order maggiore), così non si creano cicli nuovi
+unsigned DeadCodeMarker::removeDeadBranches() {
+  unsigned Count = 0;
+  for (BasicBlock *BB : Reachable) {
+    Instruction *T = BB->getTerminator();
+    if (Live.count(T) || T->getNumSuccessors() < 2)
+      continue;
+
+    BasicBlock *Target = nullptr;
+    for (BasicBlock *Succ : successors(BB))
+      if (!Target || PostOrder.lookup(Succ) > PostOrder.lookup(Target))
+        Target = Succ;
+
+    bool First = true;
+    for (BasicBlock *Succ : successors(BB)) {
+      if (Succ == Target && First)
+        First = false;
+      else
+        Succ->removePredecessor(BB, /*KeepOneInputPHIs=*/true);
+    }
+
+    outs() << "[AggressiveDCE]: " << *T << " -> br ";
+    Target->printAsOperand(outs(), false);
+    outs() << "\n";
+    BranchInst::Create(Target, T);
+    T->eraseFromParent();
+    ++Count;
+  }
+  return Count;
+}
+
+unsigned DeadCodeMarker::removeDeadInstructions() {
+  SmallVector<Instruction *, 16> Dead;
+  for (BasicBlock *BB : Reachable)
+    for (Instruction &I : *BB)
+      if (!I.isTerminator() && !isa<DbgInfoIntrinsic>(I) && !Live.count(&I))
+        Dead.push_back(&I);
+
+  // le istruzioni morte possono usarsi a vicenda (anche in ciclo)
+  for (Instruction *I : Dead)
+    I->dropAllReferences();
+  for (Instruction *I : Dead) {
+    if (!I->use_empty())
+      I->replaceAllUsesWith(UndefValue::get(I->getType()));
+    I->eraseFromParent();
+  }
+  return Dead.size();
+}
+
+PreservedAnalyses AggressiveDCE::run(Function &F, FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  PostDominatorTree &PDT = AM.getResult<PostDominatorTreeAnalysis>(F);
+  LoopInfo &LI = AM.getResult<LoopAnalysis>(F);
+  ScalarEvolution &SE = AM.getResult<ScalarEvolutionAnalysis>(F);
+
+  DeadCodeMarker Marker(F, PDT);
+  Marker.markRoots(LI, SE);
+  Marker.propagate();
+
+  unsigned Branches = Marker.removeDeadBranches();
+  unsigned Instructions = Marker.removeDeadInstructions();
+  if (Branches == 0 && Instructions == 0)
+    return PreservedAnalyses::all();
+
+  // i blocchi protetti dai branch morti non sono più raggiungibili; quelli
+  // rimasti vuoti vengono fusi nel successore, gli altri nel predecessore
+  // quando l'arco non è critico
+  removeUnreachableBlocks(F);
+  SmallVector<BasicBlock *, 8> Empty;
+  SmallVector<BasicBlock *, 8> Chained;
+  for (BasicBlock &BB : F) {
+    auto *BI = dyn_cast<BranchInst>(BB.getTerminator());
+    if (&BB != &F.getEntryBlock() && BB.size() == 1 && BI &&
+        BI->isUnconditional())
+      Empty.push_back(&BB);
+    else if (BB.getSinglePredecessor())
+      Chained.push_back(&BB);
+  }
+  for (BasicBlock *BB : Empty)
+    TryToSimplifyUncondBranchFromEmptyBlock(BB);
+  for (BasicBlock *BB : Chained)
+    MergeBlockIntoPredecessor(BB);
+
+  outs() << "[AggressiveDCE]: " << F.getName() << ": rimosse " << Instructions
+         << " istruzioni morte, " << Branches << " branch resi incondizionati\n";
+  return PreservedAnalyses::none();
+}
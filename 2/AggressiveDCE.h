@@ -0,0 +1,20 @@
+#ifndef LLVM_TRANSFORMS_AGGRESSIVEDCE_H
+#define LLVM_TRANSFORMS_AGGRESSIVEDCE_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+// Aggressive Dead Code Elimination: un'istruzione è viva solo se ha effetti
+// collaterali o se da essa dipende, tramite dipendenze sui dati o di
+// controllo, un'istruzione viva. Le dipendenze di controllo sono ricavate dal
+// PostDominatorTree; i branch morti diventano incondizionati e il codice che
+// proteggevano viene rimosso, compresi i loop rimasti senza effetti
+class AggressiveDCE : public PassInfoMixin<AggressiveDCE> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_AGGRESSIVEDCE_H
@@ -0,0 +1,118 @@
+#include "llvm/Transforms/Utils/CodeHoisting.h"
+#include "llvm/Transforms/Utils/DataflowAnalysis.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+
+using namespace llvm;
+
+// Solleva l'espressione di Rep alla fine di BB e sostituisce le valutazioni
+// nei blocchi dominati da BB. I blocchi modificati, compresi quelli degli
+// utilizzi delle valutazioni sostituite, vengono invalidati nel solver
+static bool hoistExpression(BasicBlock *BB, BinaryOperator *Rep,
+                            DominatorTree &DT, DataflowSolver &Solver) {
+  if (!Rep || !isSafeToSpeculativelyExecute(Rep))
+    return false;
+
+  // gli operandi devono essere disponibili alla fine di BB
+  Instruction *Term = BB->getTerminator();
+  for (Value *Op : Rep->operands())
+    if (auto *OpI = dyn_cast<Instruction>(Op))
+      if (!DT.dominates(OpI, Term))
+        return false;
+
+  BinaryOperator *Existing = nullptr;
+  SmallVector<BinaryOperator *, 4> Occurrences;
+  for (BasicBlock &Other : *BB->getParent()) {
+    if (&Other != BB && !DT.dominates(BB, &Other))
+      continue;
+    for (Instruction &I : Other) {
+      auto *BO = dyn_cast<BinaryOperator>(&I);
+      if (!BO || BO->getOpcode() != Rep->getOpcode() ||
+          BO->getOperand(0) != Rep->getOperand(0) ||
+          BO->getOperand(1) != Rep->getOperand(1))
+        continue;
+      if (&Other == BB && !Existing)
+        Existing = BO;
+      else
+        Occurrences.push_back(BO);
+    }
+  }
+
+  // conviene solo se almeno una valutazione viene eliminata
+  if (Occurrences.size() < (Existing ? 1u : 2u))
+    return false;
+
+  Instruction *Hoisted = Existing;
+  if (!Hoisted) {
+    Hoisted = Rep->clone();
+    Hoisted->insertBefore(Term);
+    Hoisted->takeName(Occurrences.front());
+  }
+
+  // flag come nsw/nuw mantenuti solo se presenti su tutte le valutazioni
+  for (BinaryOperator *Occ : Occurrences)
+    Hoisted->andIRFlags(Occ);
+
+  outs() << "[CodeHoisting]: " << *Hoisted << " sollevata in ";
+  BB->printAsOperand(outs(), false);
+  outs() << ", eliminate " << Occurrences.size() << " valutazioni\n";
+
+  SmallPtrSet<BasicBlock *, 8> Changed;
+  Changed.insert(BB);
+  for (BinaryOperator *Occ : Occurrences) {
+    Changed.insert(Occ->getParent());
+    for (User *U : Occ->users())
+      Changed.insert(cast<Instruction>(U)->getParent());
+    Occ->replaceAllUsesWith(Hoisted);
+    Occ->eraseFromParent();
+  }
+  for (BasicBlock *Block : Changed)
+    Solver.invalidate(Block);
+  return true;
+}
+
+// Solleva la prima espressione utile secondo la soluzione corrente della
+// Very Busy Expressions, visitando i branch in preorder sul dominator tree
+static bool hoistOne(VeryBusyExpressions &VBE, DataflowSolver &Solver,
+                     DominatorTree &DT) {
+  for (DomTreeNode *Node : depth_first(DT.getRootNode())) {
+    BasicBlock *BB = Node->getBlock();
+    if (BB->getTerminator()->getNumSuccessors() < 2)
+      continue;
+
+    bool Hoisted = false;
+    Solver.getOut(BB).forEach([&](unsigned Expr) {
+      if (!Hoisted)
+        Hoisted =
+            hoistExpression(BB, VBE.getRepresentative(Expr), DT, Solver);
+    });
+    if (Hoisted)
+      return true;
+  }
+  return false;
+}
+
+PreservedAnalyses CodeHoisting::run(Function &F, FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  DominatorTree &DT = AM.getResult<DominatorTreeAnalysis>(F);
+
+  // ogni sollevamento cambia le espressioni del dominio: il problema viene
+  // risolto di nuovo, solo sui blocchi interessati dalla modifica, finché non
+  // ci sono più espressioni da sollevare
+  VeryBusyExpressions VBE;
+  DataflowSolver Solver(F, VBE);
+  Solver.solve();
+
+  bool Transformed = false;
+  while (hoistOne(VBE, Solver, DT)) {
+    Solver.resolve();
+    Transformed = true;
+  }
+
+  if (!Transformed)
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
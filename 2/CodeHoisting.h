@@ -0,0 +1,18 @@
+#ifndef LLVM_TRANSFORMS_CODEHOISTING_H
+#define LLVM_TRANSFORMS_CODEHOISTING_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+// Code hoisting guidato dalla Very Busy Expressions: un'espressione very busy
+// all'uscita di un branch viene calcolata una sola volta nel blocco del branch
+// e sostituisce le sue valutazioni nei blocchi dominati
+class CodeHoisting : public PassInfoMixin<CodeHoisting> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_CODEHOISTING_H
@@ -0,0 +1,1317 @@
+#include "llvm/Transforms/Utils/DataflowAnalysis.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+#include <algorithm>
+
+using namespace llvm;
+
+// soglie per la scelta della rappresentazione
+static const unsigned DenseUniverseLimit = 128; // domini piccoli: sempre dense
+static const unsigned DenseRatio = 8;           // dense oltre 1/8 di densità
+
+//===----------------------------------------------------------------------===//
+// DataflowSet
+//===----------------------------------------------------------------------===//
+
+static void *allocateIn(BumpPtrAllocator *Arena, size_t Size) {
+  if (Arena)
+    return Arena->Allocate(Size, Align(alignof(uint64_t)));
+  return safe_malloc(Size);
+}
+
+// la memoria presa dall'arena viene rilasciata tutta insieme con essa
+static void releaseIn(BumpPtrAllocator *Arena, void *Ptr) {
+  if (!Arena)
+    free(Ptr);
+}
+
+static uint64_t lastWordMask(unsigned Universe) {
+  return Universe % 64 ? (uint64_t(1) << (Universe % 64)) - 1 : ~uint64_t(0);
+}
+
+DataflowSet::DataflowSet(unsigned Universe, bool Full,
+                         BumpPtrAllocator *Arena)
+    : Arena(Arena), Universe(Universe) {
+  Kind = chooseRepr();
+  if (Kind == Dense) {
+    reserveWords(numWords(), 0);
+    std::fill(Words, Words + numWords(), 0);
+  }
+  if (Full)
+    fill();
+}
+
+DataflowSet::DataflowSet(const DataflowSet &Other) { copyFrom(Other); }
+
+DataflowSet::DataflowSet(DataflowSet &&Other) noexcept {
+  Arena = Other.Arena;
+  stealFrom(Other);
+}
+
+DataflowSet &DataflowSet::operator=(const DataflowSet &Other) {
+  if (this != &Other)
+    copyFrom(Other);
+  return *this;
+}
+
+DataflowSet &DataflowSet::operator=(DataflowSet &&Other) {
+  if (this == &Other)
+    return *this;
+  if (Arena != Other.Arena) {
+    copyFrom(Other);
+    return *this;
+  }
+  releaseStorage();
+  stealFrom(Other);
+  return *this;
+}
+
+DataflowSet::~DataflowSet() { releaseStorage(); }
+
+void DataflowSet::releaseStorage() {
+  if (Words != InlineStorage)
+    releaseIn(Arena, Words);
+  if (Chunks)
+    releaseIn(Arena, Chunks);
+  Words = InlineStorage;
+  WordCap = InlineWords;
+  Chunks = nullptr;
+  NumChunks = ChunkCap = 0;
+}
+
+// copia il contenuto riusando la memoria già presente
+void DataflowSet::copyFrom(const DataflowSet &Other) {
+  Universe = Other.Universe;
+  Count = Other.Count;
+  Kind = Other.Kind;
+  switch (Kind) {
+  case Small:
+    std::copy(Other.SmallElems, Other.SmallElems + Count, SmallElems);
+    break;
+  case Sparse:
+    reserveChunks(Other.NumChunks);
+    std::copy(Other.Chunks, Other.Chunks + Other.NumChunks, Chunks);
+    NumChunks = Other.NumChunks;
+    break;
+  case Dense:
+    reserveWords(numWords(), 0);
+    std::copy(Other.Words, Other.Words + numWords(), Words);
+    break;
+  }
+}
+
+// prende la memoria di Other, che resta vuoto; stessa arena
+void DataflowSet::stealFrom(DataflowSet &Other) {
+  Universe = Other.Universe;
+  Count = Other.Count;
+  Kind = Other.Kind;
+  std::copy(Other.SmallElems, Other.SmallElems + SmallLimit, SmallElems);
+  if (Other.Words == Other.InlineStorage) {
+    std::copy(Other.InlineStorage, Other.InlineStorage + InlineWords,
+              InlineStorage);
+    Words = InlineStorage;
+    WordCap = InlineWords;
+  } else {
+    Words = Other.Words;
+    WordCap = Other.WordCap;
+  }
+  Chunks = Other.Chunks;
+  NumChunks = Other.NumChunks;
+  ChunkCap = Other.ChunkCap;
+
+  Other.Words = Other.InlineStorage;
+  Other.WordCap = InlineWords;
+  Other.Chunks = nullptr;
+  Other.NumChunks = Other.ChunkCap = 0;
+  Other.Count = 0;
+  Other.Kind = Small;
+}
+
+// capacità per N parole, conservando le prime Keep
+void DataflowSet::reserveWords(unsigned N, unsigned Keep) {
+  if (N <= WordCap)
+    return;
+  unsigned NewCap = std::max(N, WordCap * 2);
+  auto *New =
+      static_cast<uint64_t *>(allocateIn(Arena, NewCap * sizeof(uint64_t)));
+  std::copy(Words, Words + Keep, New);
+  if (Words != InlineStorage)
+    releaseIn(Arena, Words);
+  Words = New;
+  WordCap = NewCap;
+}
+
+// capacità per N parole sparse, conservando quelle presenti
+void DataflowSet::reserveChunks(unsigned N) {
+  if (N <= ChunkCap)
+    return;
+  unsigned NewCap = std::max(N, ChunkCap * 2);
+  auto *New = static_cast<Chunk *>(allocateIn(Arena, NewCap * sizeof(Chunk)));
+  std::copy(Chunks, Chunks + NumChunks, New);
+  if (Chunks)
+    releaseIn(Arena, Chunks);
+  Chunks = New;
+  ChunkCap = NewCap;
+}
+
+void DataflowSet::countBits() {
+  Count = 0;
+  if (Kind == Dense)
+    for (unsigned W = 0, E = numWords(); W < E; ++W)
+      Count += popcount(Words[W]);
+  else
+    for (unsigned C = 0; C < NumChunks; ++C)
+      Count += popcount(Chunks[C].Bits);
+}
+
+// rimuove le parole sparse rimaste vuote
+void DataflowSet::compactChunks() {
+  unsigned Last = 0;
+  for (unsigned C = 0; C < NumChunks; ++C)
+    if (Chunks[C].Bits)
+      Chunks[Last++] = Chunks[C];
+  NumChunks = Last;
+}
+
+// parola Idx di questo insieme; Cursor permette di scorrere le
+// rappresentazioni ordinate quando Idx cresce tra chiamate successive
+uint64_t DataflowSet::wordAt(unsigned Idx, unsigned &Cursor) const {
+  switch (Kind) {
+  case Small: {
+    while (Cursor < Count && SmallElems[Cursor] / 64 < Idx)
+      ++Cursor;
+    uint64_t Bits = 0;
+    for (unsigned I = Cursor; I < Count && SmallElems[I] / 64 == Idx; ++I)
+      Bits |= uint64_t(1) << (SmallElems[I] % 64);
+    return Bits;
+  }
+  case Sparse:
+    while (Cursor < NumChunks && Chunks[Cursor].Idx < Idx)
+      ++Cursor;
+    return Cursor < NumChunks && Chunks[Cursor].Idx == Idx
+               ? Chunks[Cursor].Bits
+               : 0;
+  case Dense:
+    return Words[Idx];
+  }
+  return 0;
+}
+
+StringRef DataflowSet::getReprName(Repr R) {
+  switch (R) {
+  case Small:
+    return "small";
+  case Sparse:
+    return "sparse";
+  case Dense:
+    return "dense";
+  }
+  return "";
+}
+
+// Le soglie hanno un'isteresi rispetto alla rappresentazione corrente per
+// evitare conversioni continue quando la densità oscilla vicino al limite
+DataflowSet::Repr DataflowSet::chooseRepr() const {
+  if (Universe <= DenseUniverseLimit)
+    return Dense;
+
+  unsigned SmallMax = Kind == Small ? SmallLimit : SmallLimit / 2;
+  if (Count <= SmallMax)
+    return Small;
+
+  unsigned DenseMin =
+      Kind == Dense ? Universe / (DenseRatio * 4) : Universe / DenseRatio;
+  if (Count >= DenseMin)
+    return Dense;
+
+  return Sparse;
+}
+
+// la memoria della rappresentazione precedente resta disponibile per le
+// conversioni successive
+void DataflowSet::convertTo(Repr R) {
+  if (R == Kind)
+    return;
+
+  switch (R) {
+  case Small: {
+    assert(Count <= SmallLimit && "Troppi elementi per Small");
+    unsigned N = 0;
+    forEach([&](unsigned Idx) { SmallElems[N++] = Idx; });
+    break;
+  }
+  case Sparse:
+    NumChunks = 0;
+    if (Kind == Dense) {
+      unsigned NonEmpty = 0;
+      for (unsigned W = 0, E = numWords(); W < E; ++W)
+        NonEmpty += Words[W] != 0;
+      reserveChunks(NonEmpty);
+      for (unsigned W = 0, E = numWords(); W < E; ++W)
+        if (Words[W])
+          Chunks[NumChunks++] = {W, Words[W]};
+    } else {
+      reserveChunks(Count);
+      for (unsigned I = 0; I < Count; ++I) {
+        unsigned Idx = SmallElems[I];
+        uint64_t Bit = uint64_t(1) << (Idx % 64);
+        if (NumChunks && Chunks[NumChunks - 1].Idx == Idx / 64)
+          Chunks[NumChunks - 1].Bits |= Bit;
+        else
+          Chunks[NumChunks++] = {Idx / 64, Bit};
+      }
+    }
+    break;
+  case Dense:
+    reserveWords(numWords(), 0);
+    std::fill(Words, Words + numWords(), 0);
+    forEach([&](unsigned Idx) {
+      Words[Idx / 64] |= uint64_t(1) << (Idx % 64);
+    });
+    break;
+  }
+  Kind = R;
+}
+
+void DataflowSet::adapt() { convertTo(chooseRepr()); }
+
+bool DataflowSet::test(unsigned Idx) const {
+  switch (Kind) {
+  case Small:
+    return std::binary_search(SmallElems, SmallElems + Count, Idx);
+  case Sparse: {
+    const Chunk *It = std::lower_bound(
+        Chunks, Chunks + NumChunks, Idx / 64,
+        [](const Chunk &C, unsigned WordIdx) { return C.Idx < WordIdx; });
+    return It != Chunks + NumChunks && It->Idx == Idx / 64 &&
+           ((It->Bits >> (Idx % 64)) & 1);
+  }
+  case Dense:
+    return (Words[Idx / 64] >> (Idx % 64)) & 1;
+  }
+  return false;
+}
+
+bool DataflowSet::insert(unsigned Idx) {
+  assert(Idx < Universe && "Fatto fuori dal dominio");
+  if (test(Idx))
+    return false;
+
+  // Small pieno: si passa prima alla rappresentazione sparse
+  if (Kind == Small && Count == SmallLimit)
+    convertTo(Sparse);
+
+  uint64_t Bit = uint64_t(1) << (Idx % 64);
+  switch (Kind) {
+  case Small: {
+    unsigned *Pos = std::lower_bound(SmallElems, SmallElems + Count, Idx);
+    std::copy_backward(Pos, SmallElems + Count, SmallElems + Count + 1);
+    *Pos = Idx;
+    break;
+  }
+  case Sparse: {
+    unsigned Pos = 0;
+    while (Pos < NumChunks && Chunks[Pos].Idx < Idx / 64)
+      ++Pos;
+    if (Pos < NumChunks && Chunks[Pos].Idx == Idx / 64) {
+      Chunks[Pos].Bits |= Bit;
+      break;
+    }
+    reserveChunks(NumChunks + 1);
+    std::copy_backward(Chunks + Pos, Chunks + NumChunks,
+                       Chunks + NumChunks + 1);
+    Chunks[Pos] = {Idx / 64, Bit};
+    ++NumChunks;
+    break;
+  }
+  case Dense:
+    Words[Idx / 64] |= Bit;
+    break;
+  }
+  ++Count;
+  adapt();
+  return true;
+}
+
+bool DataflowSet::erase(unsigned Idx) {
+  if (!test(Idx))
+    return false;
+
+  uint64_t Bit = uint64_t(1) << (Idx % 64);
+  switch (Kind) {
+  case Small: {
+    unsigned *Pos = std::lower_bound(SmallElems, SmallElems + Count, Idx);
+    std::copy(Pos + 1, SmallElems + Count, Pos);
+    break;
+  }
+  case Sparse:
+    for (unsigned C = 0; C < NumChunks; ++C)
+      if (Chunks[C].Idx == Idx / 64)
+        Chunks[C].Bits &= ~Bit;
+    compactChunks();
+    break;
+  case Dense:
+    Words[Idx / 64] &= ~Bit;
+    break;
+  }
+  --Count;
+  adapt();
+  return true;
+}
+
+void DataflowSet::clear() {
+  Count = 0;
+  NumChunks = 0;
+  Kind = chooseRepr();
+  if (Kind == Dense) {
+    reserveWords(numWords(), 0);
+    std::fill(Words, Words + numWords(), 0);
+  }
+}
+
+void DataflowSet::fill() {
+  Count = Universe;
+  Kind = chooseRepr();
+
+  switch (Kind) {
+  case Small:
+    for (unsigned Idx = 0; Idx < Universe; ++Idx)
+      SmallElems[Idx] = Idx;
+    break;
+  case Sparse:
+    reserveChunks(numWords());
+    NumChunks = numWords();
+    for (unsigned W = 0; W < NumChunks; ++W)
+      Chunks[W] = {W, ~uint64_t(0)};
+    if (NumChunks)
+      Chunks[NumChunks - 1].Bits = lastWordMask(Universe);
+    break;
+  case Dense:
+    reserveWords(numWords(), 0);
+    std::fill(Words, Words + numWords(), ~uint64_t(0));
+    if (numWords())
+      Words[numWords() - 1] = lastWordMask(Universe);
+    break;
+  }
+}
+
+void DataflowSet::grow(unsigned NewUniverse) {
+  assert(NewUniverse >= Universe && "Il dominio può solo crescere");
+  if (Kind == Dense) {
+    unsigned OldWords = numWords();
+    unsigned NewWords = (NewUniverse + 63) / 64;
+    reserveWords(NewWords, OldWords);
+    std::fill(Words + OldWords, Words + NewWords, 0);
+  }
+  Universe = NewUniverse;
+  adapt();
+}
+
+// unione di due insiemi sparse, fusa dal fondo senza buffer temporanei
+void DataflowSet::unionChunks(const DataflowSet &Other) {
+  unsigned A = 0, B = 0, N = 0;
+  while (A < NumChunks || B < Other.NumChunks) {
+    if (B == Other.NumChunks ||
+        (A < NumChunks && Chunks[A].Idx < Other.Chunks[B].Idx))
+      ++A;
+    else if (A == NumChunks || Other.Chunks[B].Idx < Chunks[A].Idx)
+      ++B;
+    else
+      ++A, ++B;
+    ++N;
+  }
+
+  reserveChunks(N);
+  int I = NumChunks - 1, J = Other.NumChunks - 1, K = N - 1;
+  while (J >= 0) {
+    if (I >= 0 && Chunks[I].Idx > Other.Chunks[J].Idx) {
+      Chunks[K--] = Chunks[I--];
+    } else if (I >= 0 && Chunks[I].Idx == Other.Chunks[J].Idx) {
+      Chunks[K--] = {Chunks[I].Idx, Chunks[I].Bits | Other.Chunks[J].Bits};
+      --I;
+      --J;
+    } else {
+      Chunks[K--] = Other.Chunks[J--];
+    }
+  }
+  NumChunks = N;
+}
+
+bool DataflowSet::unionWith(const DataflowSet &Other) {
+  assert(Universe == Other.Universe && "Domini diversi");
+  if (this == &Other)
+    return false;
+  unsigned OldCount = Count;
+
+  if (Other.Kind == Small) {
+    Other.forEach([&](unsigned Idx) { insert(Idx); });
+    return Count != OldCount;
+  }
+
+  if (Kind == Small) {
+    // il risultato contiene Other: si parte da una sua copia
+    unsigned Saved[SmallLimit];
+    unsigned NumSaved = Count;
+    std::copy(SmallElems, SmallElems + Count, Saved);
+    copyFrom(Other);
+    for (unsigned I = 0; I < NumSaved; ++I)
+      insert(Saved[I]);
+    return Count != OldCount;
+  }
+
+  if (Other.Kind == Dense)
+    convertTo(Dense);
+  if (Kind == Dense) {
+    unsigned Cursor = 0;
+    for (unsigned W = 0, E = numWords(); W < E; ++W)
+      Words[W] |= Other.wordAt(W, Cursor);
+  } else {
+    unionChunks(Other);
+  }
+  countBits();
+
+  adapt();
+  return Count != OldCount;
+}
+
+bool DataflowSet::intersectWith(const DataflowSet &Other) {
+  assert(Universe == Other.Universe && "Domini diversi");
+  if (this == &Other)
+    return false;
+  unsigned OldCount = Count;
+
+  unsigned Cursor = 0;
+  switch (Kind) {
+  case Small: {
+    unsigned N = 0;
+    for (unsigned I = 0; I < Count; ++I)
+      if (Other.test(SmallElems[I]))
+        SmallElems[N++] = SmallElems[I];
+    Count = N;
+    break;
+  }
+  case Sparse:
+    for (unsigned C = 0; C < NumChunks; ++C)
+      Chunks[C].Bits &= Other.wordAt(Chunks[C].Idx, Cursor);
+    compactChunks();
+    countBits();
+    break;
+  case Dense:
+    for (unsigned W = 0, E = numWords(); W < E; ++W)
+      Words[W] &= Other.wordAt(W, Cursor);
+    countBits();
+    break;
+  }
+
+  adapt();
+  return Count != OldCount;
+}
+
+bool DataflowSet::subtract(const DataflowSet &Other) {
+  assert(Universe == Other.Universe && "Domini diversi");
+  unsigned OldCount = Count;
+  if (this == &Other) {
+    clear();
+    return OldCount != 0;
+  }
+
+  unsigned Cursor = 0;
+  switch (Kind) {
+  case Small: {
+    unsigned N = 0;
+    for (unsigned I = 0; I < Count; ++I)
+      if (!Other.test(SmallElems[I]))
+        SmallElems[N++] = SmallElems[I];
+    Count = N;
+    break;
+  }
+  case Sparse:
+    for (unsigned C = 0; C < NumChunks; ++C)
+      Chunks[C].Bits &= ~Other.wordAt(Chunks[C].Idx, Cursor);
+    compactChunks();
+    countBits();
+    break;
+  case Dense:
+    for (unsigned W = 0, E = numWords(); W < E; ++W)
+      Words[W] &= ~Other.wordAt(W, Cursor);
+    countBits();
+    break;
+  }
+
+  adapt();
+  return Count != OldCount;
+}
+
+bool DataflowSet::operator==(const DataflowSet &Other) const {
+  if (Universe != Other.Universe || Count != Other.Count)
+    return false;
+
+  if (Kind == Other.Kind) {
+    switch (Kind) {
+    case Small:
+      return std::equal(SmallElems, SmallElems + Count, Other.SmallElems);
+    case Sparse:
+      return std::equal(Chunks, Chunks + NumChunks, Other.Chunks,
+                        [](const Chunk &A, const Chunk &B) {
+                          return A.Idx == B.Idx && A.Bits == B.Bits;
+                        });
+    case Dense:
+      return std::equal(Words, Words + numWords(), Other.Words);
+    }
+  }
+
+  bool Equal = true;
+  forEach([&](unsigned Idx) { Equal &= Other.test(Idx); });
+  return Equal;
+}
+
+//===----------------------------------------------------------------------===//
+// DataflowProblem e DataflowSolver
+//===----------------------------------------------------------------------===//
+
+const DataflowSet &DataflowProblem::getGen(const BasicBlock *BB) const {
+  auto It = Gen.find(BB);
+  assert(It != Gen.end() && "Blocco senza Gen");
+  return It->second;
+}
+
+const DataflowSet &DataflowProblem::getKill(const BasicBlock *BB) const {
+  auto It = Kill.find(BB);
+  assert(It != Kill.end() && "Blocco senza Kill");
+  return It->second;
+}
+
+void DataflowProblem::transfer(const BasicBlock *BB, const DataflowSet &X,
+                               DataflowSet &Result) const {
+  Result = X;
+  auto KillIt = Kill.find(BB);
+  if (KillIt != Kill.end())
+    Result.subtract(KillIt->second);
+  auto GenIt = Gen.find(BB);
+  if (GenIt != Gen.end())
+    Result.unionWith(GenIt->second);
+}
+
+void DataflowSolver::meet(unsigned Idx, DataflowSet &Result) const {
+  BasicBlock *BB = Order[Idx];
+  bool Forward = P.getDirection() == DataflowProblem::Forward;
+
+  SmallVector<unsigned, 4> Neighbours;
+  if (Forward) {
+    for (BasicBlock *Pred : predecessors(BB)) {
+      auto It = Index.find(Pred);
+      if (It != Index.end())
+        Neighbours.push_back(It->second);
+    }
+  } else {
+    for (BasicBlock *Succ : successors(BB)) {
+      auto It = Index.find(Succ);
+      if (It != Index.end())
+        Neighbours.push_back(It->second);
+    }
+  }
+
+  // entry (forward) o blocchi di uscita (backward): condizione al bordo
+  if ((Forward && BB == &F.getEntryBlock()) || Neighbours.empty()) {
+    Result = Boundary;
+    return;
+  }
+
+  Result = Initial;
+  for (unsigned N : Neighbours) {
+    const DataflowSet &Value = Forward ? Out[N] : In[N];
+    if (P.getMeet() == DataflowProblem::Union)
+      Result.unionWith(Value);
+    else
+      Result.intersectWith(Value);
+  }
+}
+
+void DataflowSolver::computeOrder() {
+  Order.clear();
+  Index.clear();
+  if (P.getDirection() == DataflowProblem::Forward) {
+    ReversePostOrderTraversal<Function *> RPOT(&F);
+    Order.assign(RPOT.begin(), RPOT.end());
+  } else {
+    for (BasicBlock *BB : post_order(&F))
+      Order.push_back(BB);
+  }
+  for (unsigned Idx = 0; Idx < Order.size(); ++Idx)
+    Index[Order[Idx]] = Idx;
+
+  // ogni blocco compare al più una volta nella worklist
+  if (Order.size() > QueueCap) {
+    QueueCap = Order.size();
+    Queue = Arena->Allocate<unsigned>(QueueCap);
+  }
+}
+
+DataflowSet DataflowSolver::makeSet() {
+  DataflowSet S(P.getUniverse(), false, Arena.get());
+  S = Initial;
+  return S;
+}
+
+void DataflowSolver::solve() {
+  P.initialize(F);
+
+  // la memoria della soluzione precedente viene rilasciata in blocco
+  In.clear();
+  Out.clear();
+  Scratch.clear();
+  Queue = nullptr;
+  QueueCap = 0;
+  Arena->Reset();
+
+  computeOrder();
+  Dirty.clear();
+  Initial = P.getInitial();
+  Boundary = P.getBoundary();
+
+  In.reserve(Order.size());
+  Out.reserve(Order.size());
+  for (unsigned Idx = 0; Idx < Order.size(); ++Idx) {
+    In.push_back(makeSet());
+    Out.push_back(makeSet());
+  }
+  Scratch.push_back(makeSet());
+  Scratch.push_back(makeSet());
+  Iterations = 0;
+  RegionSize = Order.size();
+
+  BitVector InWorklist(Order.size(), true);
+  for (unsigned Idx = 0; Idx < Order.size(); ++Idx)
+    Queue[Idx] = Idx;
+  iterate(Order.size(), InWorklist);
+  CompactedBytes = Arena->getBytesAllocated();
+}
+
+// Copia IN/OUT in un'arena nuova e rilascia quella vecchia, con la memoria
+// lasciata dagli insiemi che sono cresciuti nelle resolve precedenti
+void DataflowSolver::compact() {
+  auto Fresh = std::make_unique<BumpPtrAllocator>();
+  auto CopySets = [&](std::vector<DataflowSet> &Sets) {
+    std::vector<DataflowSet> Copy;
+    Copy.reserve(Sets.size());
+    for (const DataflowSet &S : Sets) {
+      Copy.emplace_back(S.universe(), false, Fresh.get());
+      Copy.back() = S;
+    }
+    Sets = std::move(Copy);
+  };
+  CopySets(In);
+  CopySets(Out);
+  CopySets(Scratch);
+  Queue = Fresh->Allocate<unsigned>(QueueCap);
+  Arena = std::move(Fresh);
+  CompactedBytes = Arena->getBytesAllocated();
+}
+
+// Solo i blocchi raggiungibili dai blocchi invalidati nella direzione del
+// problema possono cambiare: vengono riportati al valore iniziale e risolti
+// di nuovo, usando come condizione al bordo i fatti degli altri blocchi.
+// Il punto fisso massimo è lo stesso di una soluzione da capo
+void DataflowSolver::resolve() {
+  if (Order.empty() || !P.update(F, Dirty)) {
+    solve();
+    return;
+  }
+
+  DenseMap<const BasicBlock *, unsigned> OldIndex = std::move(Index);
+  std::vector<DataflowSet> OldIn = std::move(In);
+  std::vector<DataflowSet> OldOut = std::move(Out);
+  computeOrder();
+  Initial = P.getInitial();
+  Boundary = P.getBoundary();
+
+  // gli insiemi dei blocchi ancora presenti vengono spostati, senza copie
+  In.clear();
+  Out.clear();
+  In.reserve(Order.size());
+  Out.reserve(Order.size());
+  for (unsigned Idx = 0; Idx < Order.size(); ++Idx) {
+    auto It = OldIndex.find(Order[Idx]);
+    if (It == OldIndex.end()) {
+      In.push_back(makeSet());
+      Out.push_back(makeSet());
+      continue;
+    }
+    In.push_back(std::move(OldIn[It->second]));
+    Out.push_back(std::move(OldOut[It->second]));
+    In.back().grow(P.getUniverse());
+    Out.back().grow(P.getUniverse());
+  }
+
+  bool Forward = P.getDirection() == DataflowProblem::Forward;
+  BitVector InWorklist(Order.size());
+  SmallVector<unsigned, 16> Stack;
+  auto Reach = [&](BasicBlock *BB) {
+    auto It = Index.find(BB);
+    if (It != Index.end() && !InWorklist.test(It->second)) {
+      InWorklist.set(It->second);
+      Stack.push_back(It->second);
+    }
+  };
+  for (BasicBlock *BB : Dirty)
+    Reach(BB);
+  Dirty.clear();
+  while (!Stack.empty()) {
+    BasicBlock *BB = Order[Stack.pop_back_val()];
+    if (Forward)
+      for (BasicBlock *Succ : successors(BB))
+        Reach(Succ);
+    else
+      for (BasicBlock *Pred : predecessors(BB))
+        Reach(Pred);
+  }
+
+  unsigned Pending = 0;
+  for (unsigned Idx : InWorklist.set_bits()) {
+    In[Idx] = Initial;
+    Out[Idx] = Initial;
+    Queue[Pending++] = Idx;
+  }
+  Iterations = 0;
+  RegionSize = Pending;
+  iterate(Pending, InWorklist);
+  if (Arena->getBytesAllocated() > 2 * CompactedBytes)
+    compact();
+}
+
+// Worklist FIFO circolare in Queue, con i primi Pending elementi da
+// visitare; gli insiemi di appoggio vengono riusati a ogni iterazione
+void DataflowSolver::iterate(unsigned Pending, BitVector &InWorklist) {
+  bool Forward = P.getDirection() == DataflowProblem::Forward;
+  unsigned Capacity = Order.size();
+  unsigned Head = 0;
+  DataflowSet &Met = Scratch[0];
+  DataflowSet &Result = Scratch[1];
+
+  while (Pending) {
+    unsigned Idx = Queue[Head];
+    Head = (Head + 1) % Capacity;
+    --Pending;
+    InWorklist.reset(Idx);
+    ++Iterations;
+
+    BasicBlock *BB = Order[Idx];
+    meet(Idx, Met);
+    P.transfer(BB, Met, Result);
+
+    // forward: IN = meet, OUT = f(IN); backward: OUT = meet, IN = f(OUT)
+    DataflowSet &MetSlot = Forward ? In[Idx] : Out[Idx];
+    DataflowSet &ResultSlot = Forward ? Out[Idx] : In[Idx];
+    std::swap(MetSlot, Met);
+    if (Result == ResultSlot)
+      continue;
+    std::swap(ResultSlot, Result);
+
+    auto Push = [&](BasicBlock *Next) {
+      auto It = Index.find(Next);
+      if (It != Index.end() && !InWorklist.test(It->second)) {
+        InWorklist.set(It->second);
+        Queue[(Head + Pending) % Capacity] = It->second;
+        ++Pending;
+      }
+    };
+    if (Forward)
+      for (BasicBlock *Succ : successors(BB))
+        Push(Succ);
+    else
+      for (BasicBlock *Pred : predecessors(BB))
+        Push(Pred);
+  }
+}
+
+const DataflowSet &DataflowSolver::getIn(const BasicBlock *BB) const {
+  auto It = Index.find(BB);
+  assert(It != Index.end() && "Blocco non raggiungibile");
+  return In[It->second];
+}
+
+const DataflowSet &DataflowSolver::getOut(const BasicBlock *BB) const {
+  auto It = Index.find(BB);
+  assert(It != Index.end() && "Blocco non raggiungibile");
+  return Out[It->second];
+}
+
+static void printSet(raw_ostream &OS, const DataflowProblem &P,
+                     const DataflowSet &S) {
+  OS << "{";
+  bool First = true;
+  S.forEach([&](unsigned Idx) {
+    if (!First)
+      OS << ", ";
+    P.printFact(OS, Idx);
+    First = false;
+  });
+  OS << "}";
+}
+
+void DataflowSolver::print(raw_ostream &OS) const {
+  OS << "[" << P.getName() << "] dominio: " << P.getUniverse()
+     << " fatti, iterazioni: " << Iterations << "\n";
+
+  unsigned ReprCount[3] = {0, 0, 0};
+  for (BasicBlock &BB : F) {
+    auto It = Index.find(&BB);
+    if (It == Index.end())
+      continue;
+    const DataflowSet &BBIn = In[It->second];
+    const DataflowSet &BBOut = Out[It->second];
+    ++ReprCount[BBIn.getRepr()];
+    ++ReprCount[BBOut.getRepr()];
+
+    BB.printAsOperand(OS, false);
+    OS << ": in = ";
+    printSet(OS, P, BBIn);
+    OS << "  out = ";
+    printSet(OS, P, BBOut);
+    OS << "\n";
+  }
+
+  OS << "Rappresentazioni: ";
+  for (unsigned R = DataflowSet::Small; R <= DataflowSet::Dense; ++R)
+    OS << DataflowSet::getReprName(DataflowSet::Repr(R)) << "="
+       << ReprCount[R] << " ";
+  OS << "\n\n";
+}
+
+//===----------------------------------------------------------------------===//
+// Very Busy Expressions
+//===----------------------------------------------------------------------===//
+
+// l'espressione di BO entra nel dominio se nuova; BO ne diventa il
+// rappresentante se le valutazioni precedenti sono state tutte rimosse
+unsigned VeryBusyExpressions::addExpression(BinaryOperator *BO) {
+  auto Key =
+      std::make_tuple(BO->getOpcode(), BO->getOperand(0), BO->getOperand(1));
+  auto Inserted = ExprIndex.insert({Key, unsigned(Exprs.size())});
+  if (Inserted.second)
+    Exprs.push_back({BO, BO->getParent()});
+  else if (!Exprs[Inserted.first->second].first)
+    Exprs[Inserted.first->second] = {BO, BO->getParent()};
+  return Inserted.first->second;
+}
+
+// Use_b: espressioni calcolate in b con operandi non definiti in b
+void VeryBusyExpressions::computeGen(BasicBlock &BB) {
+  DataflowSet &Use = Gen[&BB] = DataflowSet(Universe);
+  for (Instruction &I : BB) {
+    int Expr = getExpression(&I);
+    if (Expr < 0)
+      continue;
+    bool Upward = true;
+    for (Value *Op : I.operands())
+      if (auto *OpI = dyn_cast<Instruction>(Op))
+        if (OpI->getParent() == &BB)
+          Upward = false;
+    if (Upward)
+      Use.insert(Expr);
+  }
+}
+
+void VeryBusyExpressions::initialize(Function &F) {
+  ExprIndex.clear();
+  Exprs.clear();
+  Gen.clear();
+  Kill.clear();
+
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (auto *BO = dyn_cast<BinaryOperator>(&I))
+        addExpression(BO);
+  Universe = Exprs.size();
+
+  for (BasicBlock &BB : F)
+    Kill[&BB] = DataflowSet(Universe);
+
+  // Def_b: in SSA ogni valore è definito una sola volta, quindi b uccide le
+  // espressioni che hanno un operando definito in b
+  for (unsigned Idx = 0; Idx < Exprs.size(); ++Idx)
+    for (Value *Op : getRepresentative(Idx)->operands())
+      if (auto *OpI = dyn_cast<Instruction>(Op))
+        Kill[OpI->getParent()].insert(Idx);
+
+  for (BasicBlock &BB : F)
+    computeGen(BB);
+}
+
+// Le espressioni dei blocchi modificati si aggiungono al dominio; Kill dei
+// blocchi modificati si ricava dagli utilizzi delle loro istruzioni, e le
+// espressioni trovate uccidono nei blocchi che ne definiscono gli operandi.
+// I rappresentanti nei blocchi modificati potrebbero essere stati rimossi:
+// vengono azzerati e ritrovati scorrendo di nuovo i blocchi
+bool VeryBusyExpressions::update(Function &F,
+                                 ArrayRef<BasicBlock *> Changed) {
+  SmallPtrSet<BasicBlock *, 8> ChangedSet(Changed.begin(), Changed.end());
+  for (auto &Expr : Exprs)
+    if (ChangedSet.count(Expr.second))
+      Expr = {nullptr, nullptr};
+
+  SmallVector<unsigned, 16> Found;
+  for (BasicBlock *BB : Changed)
+    for (Instruction &I : *BB)
+      if (auto *BO = dyn_cast<BinaryOperator>(&I))
+        Found.push_back(addExpression(BO));
+
+  if (Exprs.size() != Universe) {
+    Universe = Exprs.size();
+    for (auto &Entry : Gen)
+      Entry.second.grow(Universe);
+    for (auto &Entry : Kill)
+      Entry.second.grow(Universe);
+  }
+
+  for (BasicBlock *BB : Changed) {
+    DataflowSet &Def = Kill[BB] = DataflowSet(Universe);
+    for (Instruction &I : *BB)
+      for (User *U : I.users())
+        if (auto *UI = dyn_cast<Instruction>(U)) {
+          int Expr = getExpression(UI);
+          if (Expr >= 0)
+            Def.insert(Expr);
+        }
+  }
+
+  for (unsigned Idx : Found)
+    for (Value *Op : getRepresentative(Idx)->operands())
+      if (auto *OpI = dyn_cast<Instruction>(Op))
+        Kill[OpI->getParent()].insert(Idx);
+
+  for (BasicBlock *BB : Changed)
+    computeGen(*BB);
+  return true;
+}
+
+int VeryBusyExpressions::getExpression(const Instruction *I) const {
+  auto *BO = dyn_cast<BinaryOperator>(I);
+  if (!BO)
+    return -1;
+  auto It = ExprIndex.find(
+      std::make_tuple(BO->getOpcode(), BO->getOperand(0), BO->getOperand(1)));
+  return It == ExprIndex.end() ? -1 : It->second;
+}
+
+void VeryBusyExpressions::printFact(raw_ostream &OS, unsigned Idx) const {
+  BinaryOperator *BO = getRepresentative(Idx);
+  if (!BO) {
+    OS << "<rimossa>";
+    return;
+  }
+  BO->getOperand(0)->printAsOperand(OS, false);
+  OS << " " << BO->getOpcodeName() << " ";
+  BO->getOperand(1)->printAsOperand(OS, false);
+}
+
+//===----------------------------------------------------------------------===//
+// Dominator Analysis
+//===----------------------------------------------------------------------===//
+
+void DominatorAnalysis::initialize(Function &F) {
+  Blocks.clear();
+  BlockIndex.clear();
+  Gen.clear();
+  Kill.clear();
+
+  for (BasicBlock &BB : F) {
+    BlockIndex[&BB] = Blocks.size();
+    Blocks.push_back(&BB);
+  }
+  Universe = Blocks.size();
+
+  // f_b(x) = {b} U x
+  for (unsigned Idx = 0; Idx < Blocks.size(); ++Idx) {
+    Gen[Blocks[Idx]] = DataflowSet(Universe);
+    Gen[Blocks[Idx]].insert(Idx);
+  }
+}
+
+// i blocchi nuovi (ad esempio inseriti su un arco) si aggiungono al dominio
+bool DominatorAnalysis::update(Function &F, ArrayRef<BasicBlock *> Changed) {
+  SmallVector<BasicBlock *, 4> New;
+  for (BasicBlock *BB : Changed)
+    if (BlockIndex.insert({BB, unsigned(Blocks.size())}).second) {
+      Blocks.push_back(BB);
+      New.push_back(BB);
+    }
+  if (New.empty())
+    return true;
+
+  Universe = Blocks.size();
+  for (auto &Entry : Gen)
+    Entry.second.grow(Universe);
+  for (BasicBlock *BB : New) {
+    Gen[BB] = DataflowSet(Universe);
+    Gen[BB].insert(BlockIndex[BB]);
+  }
+  return true;
+}
+
+void DominatorAnalysis::printFact(raw_ostream &OS, unsigned Idx) const {
+  Blocks[Idx]->printAsOperand(OS, false);
+}
+
+//===----------------------------------------------------------------------===//
+// Constant Propagation
+//===----------------------------------------------------------------------===//
+
+void ConstantPropagation::initialize(Function &F) {
+  VarPairs.clear();
+  PairIndex.clear();
+  Pairs.clear();
+  Gen.clear();
+  Kill.clear();
+
+  // variabili = alloca promuovibili (solo load e store dirette)
+  for (Instruction &I : F.getEntryBlock())
+    if (auto *AI = dyn_cast<AllocaInst>(&I))
+      if (isAllocaPromotable(AI))
+        VarPairs[AI];
+
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        auto *AI = dyn_cast<AllocaInst>(SI->getPointerOperand());
+        auto *C = dyn_cast<ConstantInt>(SI->getValueOperand());
+        if (!AI || !C || !VarPairs.count(AI))
+          continue;
+        auto Key = std::make_pair(AI, C);
+        if (PairIndex.insert({Key, Pairs.size()}).second) {
+          VarPairs[AI].push_back(Pairs.size());
+          Pairs.push_back(Key);
+        }
+      }
+  Universe = Pairs.size();
+
+  for (BasicBlock &BB : F)
+    computeTransfer(BB);
+}
+
+void ConstantPropagation::computeTransfer(BasicBlock &BB) {
+  DataflowSet &Def = Gen[&BB] = DataflowSet(Universe);
+  DataflowSet &Killed = Kill[&BB] = DataflowSet(Universe);
+
+  // vale l'ultima store del blocco su ciascuna variabile
+  std::map<AllocaInst *, StoreInst *> LastStore;
+  for (Instruction &I : BB)
+    if (auto *SI = dyn_cast<StoreInst>(&I))
+      if (auto *AI = dyn_cast<AllocaInst>(SI->getPointerOperand()))
+        if (VarPairs.count(AI))
+          LastStore[AI] = SI;
+
+  for (auto &Entry : LastStore) {
+    for (unsigned Idx : VarPairs[Entry.first])
+      Killed.insert(Idx);
+    if (auto *C = dyn_cast<ConstantInt>(Entry.second->getValueOperand()))
+      Def.insert(PairIndex[{Entry.first, C}]);
+  }
+}
+
+// Le nuove coppie dei blocchi modificati si aggiungono al dominio e vengono
+// uccise da ogni store sulla stessa variabile, anche fuori da Changed
+bool ConstantPropagation::update(Function &F,
+                                 ArrayRef<BasicBlock *> Changed) {
+  SmallVector<unsigned, 4> New;
+  for (BasicBlock *BB : Changed)
+    for (Instruction &I : *BB)
+      if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        auto *AI = dyn_cast<AllocaInst>(SI->getPointerOperand());
+        auto *C = dyn_cast<ConstantInt>(SI->getValueOperand());
+        if (!AI || !C || !VarPairs.count(AI))
+          continue;
+        auto Key = std::make_pair(AI, C);
+        if (PairIndex.insert({Key, Pairs.size()}).second) {
+          VarPairs[AI].push_back(Pairs.size());
+          New.push_back(Pairs.size());
+          Pairs.push_back(Key);
+        }
+      }
+
+  if (!New.empty()) {
+    Universe = Pairs.size();
+    for (auto &Entry : Gen)
+      Entry.second.grow(Universe);
+    for (auto &Entry : Kill)
+      Entry.second.grow(Universe);
+    for (unsigned Idx : New)
+      for (User *U : Pairs[Idx].first->users())
+        if (auto *SI = dyn_cast<StoreInst>(U))
+          if (SI->getPointerOperand() == Pairs[Idx].first)
+            Kill[SI->getParent()].insert(Idx);
+  }
+
+  for (BasicBlock *BB : Changed)
+    computeTransfer(*BB);
+  return true;
+}
+
+void ConstantPropagation::printFact(raw_ostream &OS, unsigned Idx) const {
+  Pairs[Idx].first->printAsOperand(OS, false);
+  OS << "=" << Pairs[Idx].second->getValue();
+}
+
+//===----------------------------------------------------------------------===//
+// Liveness
+//===----------------------------------------------------------------------===//
+
+bool Liveness::isTracked(const Value *V) {
+  if (V->getType()->isVoidTy())
+    return false;
+  // le alloca statiche diventano indirizzi nello stack frame
+  if (auto *AI = dyn_cast<AllocaInst>(V))
+    return !AI->isStaticAlloca();
+  return isa<Argument>(V) || isa<Instruction>(V);
+}
+
+void Liveness::initialize(Function &F) {
+  ValueIndex.clear();
+  Values.clear();
+  Gen.clear();
+  Kill.clear();
+
+  auto Track = [&](Value *V) {
+    if (!isTracked(V))
+      return;
+    ValueIndex[V] = Values.size();
+    Values.push_back(V);
+  };
+  for (Argument &A : F.args())
+    Track(&A);
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      Track(&I);
+  Universe = Values.size();
+
+  for (BasicBlock &BB : F) {
+    DataflowSet &Use = Gen[&BB] = DataflowSet(Universe);
+    DataflowSet &Def = Kill[&BB] = DataflowSet(Universe);
+
+    // in SSA una definizione precede tutti gli usi nello stesso blocco,
+    // tranne che per le PHI: sono upward-exposed gli usi di valori definiti
+    // in altri blocchi
+    auto UseFromOutside = [&](Value *V) {
+      int Idx = getValueIndex(V);
+      auto *I = dyn_cast<Instruction>(V);
+      if (Idx >= 0 && (!I || I->getParent() != &BB))
+        Use.insert(Idx);
+    };
+
+    for (Instruction &I : BB) {
+      int Idx = getValueIndex(&I);
+      if (Idx >= 0)
+        Def.insert(Idx);
+      if (isa<PHINode>(I))
+        continue;
+      for (Value *Op : I.operands())
+        UseFromOutside(Op);
+    }
+
+    for (BasicBlock *Succ : successors(&BB))
+      for (PHINode &Phi : Succ->phis())
+        for (unsigned In = 0; In < Phi.getNumIncomingValues(); ++In)
+          if (Phi.getIncomingBlock(In) == &BB)
+            UseFromOutside(Phi.getIncomingValue(In));
+  }
+}
+
+int Liveness::getValueIndex(const Value *V) const {
+  auto It = ValueIndex.find(V);
+  return It == ValueIndex.end() ? -1 : It->second;
+}
+
+void Liveness::printFact(raw_ostream &OS, unsigned Idx) const {
+  Values[Idx]->printAsOperand(OS, false);
+}
+
+//===----------------------------------------------------------------------===//
+// ModuleDataflow
+//===----------------------------------------------------------------------===//
+
+void ModuleDataflow::run(unsigned Threads) {
+  Index.clear();
+  Results.clear();
+  for (Function &F : M)
+    if (!F.isDeclaration()) {
+      Index[&F] = Results.size();
+      Results.emplace_back();
+    }
+
+  // i risultati sono preallocati: ogni task scrive solo nel proprio slot e
+  // non servono lock
+  ThreadPool Pool(hardware_concurrency(Threads));
+  for (Function &F : M) {
+    auto It = Index.find(&F);
+    if (It == Index.end())
+      continue;
+    Result &R = Results[It->second];
+    Pool.async([this, &F, &R] {
+      R.Problem = Factory();
+      R.Solver = std::make_unique<DataflowSolver>(F, *R.Problem);
+      R.Solver->solve();
+    });
+  }
+  Pool.wait();
+}
+
+DataflowProblem *ModuleDataflow::getProblem(const Function &F) const {
+  auto It = Index.find(&F);
+  return It == Index.end() ? nullptr : Results[It->second].Problem.get();
+}
+
+DataflowSolver *ModuleDataflow::getSolver(const Function &F) const {
+  auto It = Index.find(&F);
+  return It == Index.end() ? nullptr : Results[It->second].Solver.get();
+}
+
+//===----------------------------------------------------------------------===//
+// Passi di stampa delle tre analisi
+//===----------------------------------------------------------------------===//
+
+PreservedAnalyses DataflowAnalysis::run(Function &F,
+                                        FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  outs() << "[DataflowAnalysis]: " << F.getName() << "\n";
+
+  VeryBusyExpressions VBE;
+  DominatorAnalysis DA;
+  ConstantPropagation CP;
+  DataflowProblem *Problems[] = {&VBE, &DA, &CP};
+
+  for (DataflowProblem *P : Problems) {
+    DataflowSolver Solver(F, *P);
+    Solver.solve();
+    Solver.print(outs());
+  }
+
+  return PreservedAnalyses::all();
+}
+
+PreservedAnalyses ParallelDataflow::run(Module &M,
+                                        ModuleAnalysisManager &AM) {
+  ModuleDataflow VBE(M,
+                     [] { return std::make_unique<VeryBusyExpressions>(); });
+  ModuleDataflow DA(M, [] { return std::make_unique<DominatorAnalysis>(); });
+  ModuleDataflow CP(M,
+                    [] { return std::make_unique<ConstantPropagation>(); });
+  ModuleDataflow *Analyses[] = {&VBE, &DA, &CP};
+  for (ModuleDataflow *MD : Analyses)
+    MD->run();
+
+  // la stampa usa gli slot tracker del modulo: avviene in un solo thread
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    outs() << "[ParallelDataflow]: " << F.getName() << "\n";
+    for (ModuleDataflow *MD : Analyses)
+      MD->getSolver(F)->print(outs());
+  }
+
+  return PreservedAnalyses::all();
+}
@@ -0,0 +1,358 @@
+#ifndef LLVM_TRANSFORMS_DATAFLOWANALYSIS_H
+#define LLVM_TRANSFORMS_DATAFLOWANALYSIS_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/bit.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Allocator.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace llvm {
+
+// Insieme di fatti (indici nel dominio del problema) usato per IN/OUT.
+// La rappresentazione viene scelta in base alla dimensione del dominio e alla
+// densità osservata, e cambia durante la soluzione quando la densità cambia:
+// - Small:  vettore ordinato, per insiemi con pochi elementi
+// - Sparse: parole di 64 fatti non vuote ordinate, per domini grandi e
+//           insiemi poco densi
+// - Dense:  bitvector, per domini piccoli o insiemi molto densi
+// La memoria delle parole viene dall'arena del solver, se indicata, e viene
+// riusata dalle operazioni successive invece di essere liberata
+class DataflowSet {
+public:
+  enum Repr { Small, Sparse, Dense };
+  static constexpr unsigned SmallLimit = 8;
+
+  DataflowSet() = default;
+  explicit DataflowSet(unsigned Universe, bool Full = false,
+                       BumpPtrAllocator *Arena = nullptr);
+  // la copia usa lo heap, perché può sopravvivere all'arena dell'originale;
+  // l'assegnamento mantiene l'allocatore di destinazione
+  DataflowSet(const DataflowSet &Other);
+  DataflowSet(DataflowSet &&Other) noexcept;
+  DataflowSet &operator=(const DataflowSet &Other);
+  DataflowSet &operator=(DataflowSet &&Other);
+  ~DataflowSet();
+
+  unsigned universe() const { return Universe; }
+  unsigned count() const { return Count; }
+  bool empty() const { return Count == 0; }
+  Repr getRepr() const { return Kind; }
+
+  bool test(unsigned Idx) const;
+  bool insert(unsigned Idx);
+  bool erase(unsigned Idx);
+  void clear();
+  void fill();
+  // estende il dominio: i nuovi fatti non appartengono all'insieme
+  void grow(unsigned NewUniverse);
+
+  // le operazioni restituiscono true se l'insieme è cambiato
+  bool unionWith(const DataflowSet &Other);
+  bool intersectWith(const DataflowSet &Other);
+  bool subtract(const DataflowSet &Other);
+
+  bool operator==(const DataflowSet &Other) const;
+  bool operator!=(const DataflowSet &Other) const { return !(*this == Other); }
+
+  template <typename Fn> void forEach(Fn F) const {
+    switch (Kind) {
+    case Small:
+      for (unsigned I = 0; I < Count; ++I)
+        F(SmallElems[I]);
+      break;
+    case Sparse:
+      for (unsigned C = 0; C < NumChunks; ++C)
+        forEachBit(Chunks[C].Idx, Chunks[C].Bits, F);
+      break;
+    case Dense:
+      for (unsigned W = 0, E = numWords(); W < E; ++W)
+        forEachBit(W, Words[W], F);
+      break;
+    }
+  }
+
+  static StringRef getReprName(Repr R);
+
+private:
+  // parola con i fatti da Idx * 64 a Idx * 64 + 63
+  struct Chunk {
+    unsigned Idx;
+    uint64_t Bits;
+  };
+  static constexpr unsigned InlineWords = 2;
+
+  template <typename Fn>
+  static void forEachBit(unsigned WordIdx, uint64_t Bits, Fn &F) {
+    while (Bits) {
+      F(WordIdx * 64 + countr_zero(Bits));
+      Bits &= Bits - 1;
+    }
+  }
+
+  unsigned numWords() const { return (Universe + 63) / 64; }
+  uint64_t wordAt(unsigned Idx, unsigned &Cursor) const;
+  void reserveWords(unsigned N, unsigned Keep);
+  void reserveChunks(unsigned N);
+  void copyFrom(const DataflowSet &Other);
+  void stealFrom(DataflowSet &Other);
+  void releaseStorage();
+  void countBits();
+  void compactChunks();
+  void unionChunks(const DataflowSet &Other);
+
+  Repr chooseRepr() const;
+  void convertTo(Repr R);
+  void adapt();
+
+  BumpPtrAllocator *Arena = nullptr;
+  unsigned Universe = 0;
+  unsigned Count = 0;
+  Repr Kind = Small;
+  unsigned SmallElems[SmallLimit];
+  uint64_t InlineStorage[InlineWords];
+  uint64_t *Words = InlineStorage;
+  unsigned WordCap = InlineWords;
+  Chunk *Chunks = nullptr;
+  unsigned NumChunks = 0;
+  unsigned ChunkCap = 0;
+};
+
+// Formalizzazione di un problema di dataflow: dominio, direzione, meet,
+// condizione al bordo, valore iniziale e funzione di trasferimento
+class DataflowProblem {
+public:
+  enum Direction { Forward, Backward };
+  enum MeetOp { Union, Intersection };
+
+  DataflowProblem(StringRef Name, Direction Dir, MeetOp Meet)
+      : Name(Name), Dir(Dir), Meet(Meet) {}
+  virtual ~DataflowProblem() = default;
+
+  StringRef getName() const { return Name; }
+  Direction getDirection() const { return Dir; }
+  MeetOp getMeet() const { return Meet; }
+  unsigned getUniverse() const { return Universe; }
+  const DataflowSet &getGen(const BasicBlock *BB) const;
+  const DataflowSet &getKill(const BasicBlock *BB) const;
+
+  // costruzione del dominio e degli insiemi Gen/Kill dei blocchi
+  virtual void initialize(Function &F) = 0;
+  // aggiornamento di Gen/Kill dopo modifiche locali ai blocchi Changed; il
+  // dominio può solo crescere. Restituisce false se il problema va
+  // ricostruito da capo con initialize
+  virtual bool update(Function &F, ArrayRef<BasicBlock *> Changed) {
+    return false;
+  }
+  virtual void printFact(raw_ostream &OS, unsigned Idx) const = 0;
+
+  // IN dell'entry (forward) o OUT delle uscite (backward)
+  virtual DataflowSet getBoundary() const { return DataflowSet(Universe); }
+  // punti interni inizializzati all'elemento neutro del meet
+  virtual DataflowSet getInitial() const {
+    return DataflowSet(Universe, Meet == Intersection);
+  }
+  // f_b(x) = Gen_b U (x - Kill_b)
+  virtual void transfer(const BasicBlock *BB, const DataflowSet &X,
+                        DataflowSet &Result) const;
+
+protected:
+  std::string Name;
+  Direction Dir;
+  MeetOp Meet;
+  unsigned Universe = 0;
+  DenseMap<const BasicBlock *, DataflowSet> Gen;
+  DenseMap<const BasicBlock *, DataflowSet> Kill;
+};
+
+// Algoritmo iterativo con worklist, visita in reverse post-order (forward)
+// o post-order (backward).
+// Dopo modifiche locali all'IR si possono invalidare i blocchi modificati
+// (compresi quelli di cui sono cambiati predecessori o successori) e
+// chiamare resolve: vengono ricalcolati solo i blocchi raggiungibili da
+// quelli invalidati nella direzione del problema, gli altri mantengono i
+// fatti della soluzione precedente
+class DataflowSolver {
+public:
+  DataflowSolver(Function &F, DataflowProblem &P) : F(F), P(P) {}
+
+  void solve();
+  void invalidate(BasicBlock *BB) { Dirty.push_back(BB); }
+  void resolve();
+
+  const DataflowSet &getIn(const BasicBlock *BB) const;
+  const DataflowSet &getOut(const BasicBlock *BB) const;
+  unsigned getIterations() const { return Iterations; }
+  // blocchi ricalcolati dall'ultima solve o resolve
+  unsigned getRegionSize() const { return RegionSize; }
+
+  void print(raw_ostream &OS) const;
+
+private:
+  void computeOrder();
+  void iterate(unsigned Pending, BitVector &InWorklist);
+  void meet(unsigned Idx, DataflowSet &Result) const;
+  DataflowSet makeSet();
+  void compact();
+
+  Function &F;
+  DataflowProblem &P;
+  std::vector<BasicBlock *> Order;
+  DenseMap<const BasicBlock *, unsigned> Index;
+  // memoria di IN/OUT e della worklist, rilasciata in blocco a ogni solve
+  // e alla distruzione del solver. Le resolve non liberano la memoria degli
+  // insiemi cresciuti: quando l'arena supera il doppio della dimensione
+  // dopo l'ultima solve, gli insiemi vengono copiati in un'arena nuova
+  std::unique_ptr<BumpPtrAllocator> Arena =
+      std::make_unique<BumpPtrAllocator>();
+  size_t CompactedBytes = 0;
+  unsigned *Queue = nullptr;
+  unsigned QueueCap = 0;
+  std::vector<DataflowSet> In;
+  std::vector<DataflowSet> Out;
+  DataflowSet Initial;
+  DataflowSet Boundary;
+  // insiemi di appoggio di iterate (meet e risultato del trasferimento),
+  // creati a ogni solve e riusati da tutte le resolve
+  std::vector<DataflowSet> Scratch;
+  SmallVector<BasicBlock *, 8> Dirty;
+  unsigned Iterations = 0;
+  unsigned RegionSize = 0;
+};
+
+// Very Busy Expressions: dominio = espressioni binarie, backward, intersezione
+class VeryBusyExpressions : public DataflowProblem {
+public:
+  VeryBusyExpressions()
+      : DataflowProblem("Very Busy Expressions", Backward, Intersection) {}
+
+  void initialize(Function &F) override;
+  bool update(Function &F, ArrayRef<BasicBlock *> Changed) override;
+  void printFact(raw_ostream &OS, unsigned Idx) const override;
+
+  // indice dell'espressione calcolata da I, -1 se I non fa parte del dominio
+  int getExpression(const Instruction *I) const;
+  // nullptr se tutte le valutazioni dell'espressione sono state rimosse
+  BinaryOperator *getRepresentative(unsigned Idx) const {
+    return Exprs[Idx].first;
+  }
+
+private:
+  unsigned addExpression(BinaryOperator *BO);
+  void computeGen(BasicBlock &BB);
+
+  std::map<std::tuple<unsigned, Value *, Value *>, unsigned> ExprIndex;
+  // rappresentante e suo blocco: niente value handle, così l'analisi non
+  // modifica lo stato del contesto e può girare in parallelo su più funzioni
+  std::vector<std::pair<BinaryOperator *, BasicBlock *>> Exprs;
+};
+
+// Dominator Analysis: dominio = basic block, forward, intersezione
+class DominatorAnalysis : public DataflowProblem {
+public:
+  DominatorAnalysis()
+      : DataflowProblem("Dominator Analysis", Forward, Intersection) {}
+
+  void initialize(Function &F) override;
+  bool update(Function &F, ArrayRef<BasicBlock *> Changed) override;
+  void printFact(raw_ostream &OS, unsigned Idx) const override;
+
+private:
+  std::vector<BasicBlock *> Blocks;
+  DenseMap<const BasicBlock *, unsigned> BlockIndex;
+};
+
+// Constant Propagation: dominio = coppie (variabile, costante) ottenute dalle
+// store di costanti su alloca promuovibili, forward, intersezione
+class ConstantPropagation : public DataflowProblem {
+public:
+  ConstantPropagation()
+      : DataflowProblem("Constant Propagation", Forward, Intersection) {}
+
+  void initialize(Function &F) override;
+  bool update(Function &F, ArrayRef<BasicBlock *> Changed) override;
+  void printFact(raw_ostream &OS, unsigned Idx) const override;
+
+private:
+  void computeTransfer(BasicBlock &BB);
+
+  std::map<AllocaInst *, SmallVector<unsigned, 4>> VarPairs;
+  std::map<std::pair<AllocaInst *, ConstantInt *>, unsigned> PairIndex;
+  std::vector<std::pair<AllocaInst *, ConstantInt *>> Pairs;
+};
+
+// Liveness: dominio = valori SSA che occupano un registro (argomenti e
+// istruzioni con risultato, escluse le alloca statiche), backward, unione.
+// Gli operandi delle PHI sono usati sull'arco: appartengono a Use del
+// predecessore da cui provengono e non a quello del blocco della PHI
+class Liveness : public DataflowProblem {
+public:
+  Liveness() : DataflowProblem("Liveness", Backward, Union) {}
+
+  void initialize(Function &F) override;
+  void printFact(raw_ostream &OS, unsigned Idx) const override;
+
+  static bool isTracked(const Value *V);
+  // indice del valore, -1 se V non fa parte del dominio
+  int getValueIndex(const Value *V) const;
+  Value *getValue(unsigned Idx) const { return Values[Idx]; }
+
+private:
+  DenseMap<const Value *, unsigned> ValueIndex;
+  std::vector<Value *> Values;
+};
+
+// Analisi di tutte le funzioni del modulo in parallelo su un pool di
+// thread. Ogni funzione ha il proprio problema e il proprio solver, scritti
+// solo dal thread che la analizza; l'IR viene solo letto. Al termine di run
+// i risultati si consumano in modo seriale, ad esempio da un passo di
+// trasformazione
+class ModuleDataflow {
+public:
+  using ProblemFactory = std::function<std::unique_ptr<DataflowProblem>()>;
+
+  ModuleDataflow(Module &M, ProblemFactory Factory)
+      : M(M), Factory(std::move(Factory)) {}
+
+  // Threads = 0: un thread per core disponibile
+  void run(unsigned Threads = 0);
+
+  // nullptr per le dichiarazioni
+  DataflowProblem *getProblem(const Function &F) const;
+  DataflowSolver *getSolver(const Function &F) const;
+
+private:
+  struct Result {
+    std::unique_ptr<DataflowProblem> Problem;
+    std::unique_ptr<DataflowSolver> Solver;
+  };
+
+  Module &M;
+  ProblemFactory Factory;
+  DenseMap<const Function *, unsigned> Index;
+  std::vector<Result> Results;
+};
+
+class DataflowAnalysis : public PassInfoMixin<DataflowAnalysis> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+// Come DataflowAnalysis, ma le tre analisi di tutte le funzioni vengono
+// risolte in parallelo con ModuleDataflow e stampate poi in ordine
+class ParallelDataflow : public PassInfoMixin<ParallelDataflow> {
+public:
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_DATAFLOWANALYSIS_H
@@ -0,0 +1,256 @@
+#include "llvm/Transforms/Utils/DominatorBench.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include <chrono>
+
+using namespace llvm;
+
+static const unsigned Undefined = ~0u;
+// ripetizioni di ogni costruzione per il benchmark
+static const unsigned BenchRepeat = 20;
+
+IDomTree::IDomTree(Function &F, Algorithm A) {
+  if (A == CooperHarveyKennedy)
+    computeCHK(F);
+  else
+    computeSemiNCA(F);
+  computeIntervals();
+}
+
+//===----------------------------------------------------------------------===//
+// Cooper-Harvey-Kennedy
+//===----------------------------------------------------------------------===//
+
+void IDomTree::computeCHK(Function &F) {
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  Blocks.assign(RPOT.begin(), RPOT.end());
+  for (unsigned Idx = 0; Idx < Blocks.size(); ++Idx)
+    Number[Blocks[Idx]] = Idx;
+
+  // predecessori numerati una sola volta, fuori dal ciclo di punto fisso
+  std::vector<SmallVector<unsigned, 2>> Preds(Blocks.size());
+  for (unsigned Idx = 1; Idx < Blocks.size(); ++Idx)
+    for (BasicBlock *Pred : predecessors(Blocks[Idx])) {
+      auto It = Number.find(Pred);
+      if (It != Number.end())
+        Preds[Idx].push_back(It->second);
+    }
+
+  IDom.assign(Blocks.size(), Undefined);
+  IDom[0] = 0;
+
+  // in reverse post-order gli antenati hanno numero minore: si risale da
+  // quello con numero maggiore finché le due dita si incontrano
+  auto Intersect = [&](unsigned B1, unsigned B2) {
+    while (B1 != B2) {
+      while (B1 > B2)
+        B1 = IDom[B1];
+      while (B2 > B1)
+        B2 = IDom[B2];
+    }
+    return B1;
+  };
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (unsigned Idx = 1; Idx < Blocks.size(); ++Idx) {
+      unsigned NewIDom = Undefined;
+      for (unsigned Pred : Preds[Idx]) {
+        if (IDom[Pred] == Undefined)
+          continue;
+        NewIDom = NewIDom == Undefined ? Pred : Intersect(Pred, NewIDom);
+      }
+      if (IDom[Idx] != NewIDom) {
+        IDom[Idx] = NewIDom;
+        Changed = true;
+      }
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Semi-NCA
+//===----------------------------------------------------------------------===//
+
+void IDomTree::computeSemiNCA(Function &F) {
+  // visita DFS iterativa in preorder
+  std::vector<unsigned> Parent;
+  SmallVector<std::pair<BasicBlock *, unsigned>, 32> Stack;
+  BasicBlock *Entry = &F.getEntryBlock();
+  Number[Entry] = 0;
+  Blocks.push_back(Entry);
+  Parent.push_back(0);
+  Stack.push_back({Entry, 0});
+
+  while (!Stack.empty()) {
+    BasicBlock *BB = Stack.back().first;
+    unsigned SuccIdx = Stack.back().second++;
+    Instruction *T = BB->getTerminator();
+    if (SuccIdx >= T->getNumSuccessors()) {
+      Stack.pop_back();
+      continue;
+    }
+    BasicBlock *Succ = T->getSuccessor(SuccIdx);
+    if (Number.count(Succ))
+      continue;
+    Number[Succ] = Blocks.size();
+    Blocks.push_back(Succ);
+    Parent.push_back(Number[BB]);
+    Stack.push_back({Succ, 0});
+  }
+
+  unsigned N = Blocks.size();
+  std::vector<unsigned> Semi(N), Label(N), Ancestor(Parent);
+  for (unsigned Idx = 0; Idx < N; ++Idx)
+    Semi[Idx] = Label[Idx] = Idx;
+
+  // eval con path compression: i nodi con numero >= LastLinked sono già
+  // collegati alla foresta
+  SmallVector<unsigned, 32> Path;
+  auto Eval = [&](unsigned V, unsigned LastLinked) {
+    if (Ancestor[V] < LastLinked)
+      return Label[V];
+    do {
+      Path.push_back(V);
+      V = Ancestor[V];
+    } while (Ancestor[V] >= LastLinked);
+
+    unsigned P = V;
+    unsigned PLabel = Label[P];
+    while (!Path.empty()) {
+      V = Path.pop_back_val();
+      Ancestor[V] = Ancestor[P];
+      if (Semi[PLabel] < Semi[Label[V]])
+        Label[V] = PLabel;
+      else
+        PLabel = Label[V];
+      P = V;
+    }
+    return Label[V];
+  };
+
+  // semidominatori in ordine inverso di preorder
+  for (unsigned W = N - 1; W >= 1; --W) {
+    Semi[W] = Parent[W];
+    for (BasicBlock *Pred : predecessors(Blocks[W])) {
+      auto It = Number.find(Pred);
+      if (It == Number.end())
+        continue;
+      unsigned SemiU = Semi[Eval(It->second, W + 1)];
+      if (SemiU < Semi[W])
+        Semi[W] = SemiU;
+    }
+  }
+
+  // dominatore immediato: primo antenato nello spanning tree con numero non
+  // maggiore del semidominatore
+  IDom = Parent;
+  for (unsigned W = 1; W < N; ++W) {
+    unsigned Candidate = IDom[W];
+    while (Candidate > Semi[W])
+      Candidate = IDom[Candidate];
+    IDom[W] = Candidate;
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Interrogazioni
+//===----------------------------------------------------------------------===//
+
+void IDomTree::computeIntervals() {
+  unsigned N = Blocks.size();
+  std::vector<SmallVector<unsigned, 4>> Children(N);
+  for (unsigned Idx = 1; Idx < N; ++Idx)
+    Children[IDom[Idx]].push_back(Idx);
+
+  DFSIn.assign(N, 0);
+  DFSOut.assign(N, 0);
+  unsigned Clock = 0;
+  SmallVector<std::pair<unsigned, unsigned>, 32> Stack;
+  Stack.push_back({0, 0});
+  DFSIn[0] = Clock++;
+  while (!Stack.empty()) {
+    unsigned Node = Stack.back().first;
+    unsigned ChildIdx = Stack.back().second++;
+    if (ChildIdx < Children[Node].size()) {
+      unsigned Child = Children[Node][ChildIdx];
+      DFSIn[Child] = Clock++;
+      Stack.push_back({Child, 0});
+    } else {
+      DFSOut[Node] = Clock++;
+      Stack.pop_back();
+    }
+  }
+}
+
+BasicBlock *IDomTree::getIDom(const BasicBlock *BB) const {
+  auto It = Number.find(BB);
+  if (It == Number.end() || It->second == 0)
+    return nullptr;
+  return Blocks[IDom[It->second]];
+}
+
+bool IDomTree::dominates(const BasicBlock *A, const BasicBlock *B) const {
+  auto BIt = Number.find(B);
+  if (BIt == Number.end())
+    return true;
+  auto AIt = Number.find(A);
+  if (AIt == Number.end())
+    return false;
+  return DFSIn[AIt->second] <= DFSIn[BIt->second] &&
+         DFSOut[BIt->second] <= DFSOut[AIt->second];
+}
+
+bool IDomTree::verify(const DominatorTree &DT) const {
+  for (BasicBlock *BB : Blocks) {
+    DomTreeNode *Node = DT.getNode(BB);
+    BasicBlock *Expected =
+        Node && Node->getIDom() ? Node->getIDom()->getBlock() : nullptr;
+    if (getIDom(BB) != Expected) {
+      outs() << "Dominatore immediato diverso per ";
+      BB->printAsOperand(outs(), false);
+      outs() << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Benchmark
+//===----------------------------------------------------------------------===//
+
+template <typename Fn> static double measure(Fn Build) {
+  auto Start = std::chrono::steady_clock::now();
+  for (unsigned Rep = 0; Rep < BenchRepeat; ++Rep)
+    Build();
+  auto End = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(End - Start).count() /
+         BenchRepeat;
+}
+
+PreservedAnalyses DominatorBench::run(Function &F,
+                                      FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  DominatorTree DT(F);
+  IDomTree CHK(F, IDomTree::CooperHarveyKennedy);
+  IDomTree SNCA(F, IDomTree::SemiNCA);
+  bool Correct = CHK.verify(DT) && SNCA.verify(DT);
+
+  double CHKTime =
+      measure([&] { IDomTree T(F, IDomTree::CooperHarveyKennedy); });
+  double SNCATime = measure([&] { IDomTree T(F, IDomTree::SemiNCA); });
+  double LLVMTime = measure([&] { DT.recalculate(F); });
+
+  outs() << "[DominatorBench]: " << F.getName() << " (" << F.size()
+         << " blocchi)\n";
+  outs() << "  Cooper-Harvey-Kennedy: " << format("%.2f", CHKTime) << " us\n";
+  outs() << "  Semi-NCA:              " << format("%.2f", SNCATime) << " us\n";
+  outs() << "  DominatorTree LLVM:    " << format("%.2f", LLVMTime) << " us\n";
+  outs() << "  Risultati coincidenti: " << (Correct ? "si" : "no") << "\n";
+
+  return PreservedAnalyses::all();
+}
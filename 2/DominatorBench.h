@@ -0,0 +1,52 @@
+#ifndef LLVM_TRANSFORMS_DOMINATORBENCH_H
+#define LLVM_TRANSFORMS_DOMINATORBENCH_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Dominators.h"
+#include <vector>
+
+namespace llvm {
+
+// Albero dei dominatori rappresentato come vettore di dominatori immediati,
+// calcolato con uno dei due algoritmi:
+// - Cooper-Harvey-Kennedy: iterativo, sui blocchi numerati in reverse
+//   post-order, con intersezione dei predecessori risalendo l'albero
+// - Semi-NCA: semidominatori con link-eval e path compression, poi
+//   dominatore immediato come antenato comune nello spanning tree DFS
+class IDomTree {
+public:
+  enum Algorithm { CooperHarveyKennedy, SemiNCA };
+
+  IDomTree(Function &F, Algorithm A);
+
+  // nullptr per l'entry e per i blocchi non raggiungibili
+  BasicBlock *getIDom(const BasicBlock *BB) const;
+  bool dominates(const BasicBlock *A, const BasicBlock *B) const;
+
+  // confronto con il DominatorTree di LLVM
+  bool verify(const DominatorTree &DT) const;
+
+private:
+  void computeCHK(Function &F);
+  void computeSemiNCA(Function &F);
+  void computeIntervals();
+
+  std::vector<BasicBlock *> Blocks;
+  DenseMap<const BasicBlock *, unsigned> Number;
+  std::vector<unsigned> IDom;
+  // intervalli della visita DFS dell'albero per dominates in O(1)
+  std::vector<unsigned> DFSIn;
+  std::vector<unsigned> DFSOut;
+};
+
+// Confronta i tempi di costruzione di Cooper-Harvey-Kennedy, Semi-NCA e del
+// DominatorTree di LLVM, verificando che i risultati coincidano
+class DominatorBench : public PassInfoMixin<DominatorBench> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_DOMINATORBENCH_H
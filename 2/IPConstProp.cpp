@@ -0,0 +1,230 @@
+#include "llvm/Transforms/Utils/IPConstProp.h"
+#include "llvm/Transforms/Utils/SparseConstProp.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <map>
+#include <memory>
+
+using namespace llvm;
+
+// specializzazioni al massimo per funzione e dimensione massima (in
+// istruzioni) delle funzioni da clonare
+static const unsigned MaxSpecializations = 4;
+static const unsigned SpecializationBudget = 500;
+
+using SolverMap = std::map<Function *, std::unique_ptr<SparseConstSolver>>;
+using SpecKey = std::vector<std::pair<unsigned, Constant *>>;
+
+// chiamata in un blocco che il solver del chiamante ha dimostrato non
+// eseguibile
+static bool isDeadCall(CallBase &CB, const SolverMap &Solvers) {
+  auto It = Solvers.find(CB.getFunction());
+  return It != Solvers.end() && !It->second->isExecutable(CB.getParent());
+}
+
+// valore costante dell'argomento attuale secondo il solver del chiamante;
+// i chiamanti non ancora risolti (stessa SCC) non danno informazioni
+static Constant *getActualConstant(CallBase &CB, unsigned Idx,
+                                   const SolverMap &Solvers) {
+  Value *V = CB.getArgOperand(Idx);
+  if (isa<UndefValue>(V))
+    return nullptr;
+  if (auto *C = dyn_cast<Constant>(V))
+    return C;
+
+  auto It = Solvers.find(CB.getFunction());
+  if (It == Solvers.end())
+    return nullptr;
+  ConstLattice L = It->second->getValue(V);
+  return L.isConstant() ? L.getConstant() : nullptr;
+}
+
+// tutte le chiamate sono note solo per funzioni locali il cui indirizzo non
+// viene preso
+static bool hasOnlyDirectCalls(Function &F) {
+  if (!F.hasLocalLinkage() || F.isVarArg())
+    return false;
+  return all_of(F.uses(), [&](Use &U) {
+    auto *CB = dyn_cast<CallBase>(U.getUser());
+    return CB && CB->isCallee(&U) &&
+           CB->getFunctionType() == F.getFunctionType();
+  });
+}
+
+// meet degli argomenti attuali su tutte le chiamate eseguibili
+static void seedArguments(Function &F, SparseConstSolver &Solver,
+                          const SolverMap &Solvers) {
+  if (!hasOnlyDirectCalls(F))
+    return;
+
+  for (Argument &A : F.args()) {
+    ConstLattice Meet;
+    for (User *U : F.users()) {
+      auto &CB = cast<CallBase>(*U);
+      if (isDeadCall(CB, Solvers))
+        continue;
+      Constant *C = getActualConstant(CB, A.getArgNo(), Solvers);
+      Meet.meet(C ? ConstLattice::getConstant(C) : ConstLattice::getBottom());
+    }
+    if (Meet.isConstant())
+      Solver.setArgument(&A, Meet.getConstant());
+  }
+}
+
+// clona F per le combinazioni di argomenti costanti più frequenti tra le
+// chiamate dirette; gli argomenti costanti vengono tolti dalla firma
+static bool specialize(Function &F, const SolverMap &Solvers) {
+  if (F.isVarArg() || F.getInstructionCount() > SpecializationBudget)
+    return false;
+
+  // gruppi nell'ordine della loro prima chiamata: la mappa serve solo a
+  // trovarli, il suo ordine dipende dagli indirizzi delle costanti
+  std::map<SpecKey, unsigned> GroupIndex;
+  std::vector<std::pair<SpecKey, SmallVector<CallInst *, 4>>> Hot;
+  for (User *U : F.users()) {
+    auto *CI = dyn_cast<CallInst>(U);
+    if (!CI || CI->getCalledFunction() != &F || isDeadCall(*CI, Solvers))
+      continue;
+    // una musttail deve avere la stessa firma del chiamante
+    if (CI->isMustTailCall())
+      continue;
+
+    // solo gli argomenti usati nel corpo rendono utile la specializzazione
+    SpecKey Key;
+    for (Argument &A : F.args()) {
+      Value *Op = CI->getArgOperand(A.getArgNo());
+      if (!A.use_empty() && isa<Constant>(Op) && !isa<UndefValue>(Op))
+        Key.push_back({A.getArgNo(), cast<Constant>(Op)});
+    }
+    if (Key.empty())
+      continue;
+    auto It = GroupIndex.try_emplace(Key, Hot.size()).first;
+    if (It->second == Hot.size())
+      Hot.push_back({Key, {}});
+    Hot[It->second].second.push_back(CI);
+  }
+
+  // a parità di chiamate resta prima il gruppo incontrato per primo
+  llvm::stable_sort(Hot, [](const auto &A, const auto &B) {
+    return A.second.size() > B.second.size();
+  });
+  if (Hot.size() > MaxSpecializations)
+    Hot.resize(MaxSpecializations);
+
+  for (auto &Entry : Hot) {
+    ValueToValueMapTy VMap;
+    SmallDenseSet<unsigned, 4> Removed;
+    for (auto &Arg : Entry.first) {
+      VMap[F.getArg(Arg.first)] = Arg.second;
+      Removed.insert(Arg.first);
+    }
+    Function *Clone = CloneFunction(&F, VMap);
+    Clone->setName(F.getName() + ".spec");
+    Clone->setLinkage(GlobalValue::InternalLinkage);
+
+    outs() << "[IPConstProp]: " << F.getName() << " specializzata in "
+           << Clone->getName() << " (";
+    for (auto &Arg : Entry.first)
+      outs() << " arg" << Arg.first << " = " << *Arg.second;
+    outs() << " ) per " << Entry.second.size() << " chiamate\n";
+
+    for (CallInst *CI : Entry.second) {
+      // gli attributi della chiamata seguono gli argomenti rimasti
+      AttributeList Attrs = CI->getAttributes();
+      SmallVector<Value *, 4> Args;
+      SmallVector<AttributeSet, 4> ArgAttrs;
+      for (Argument &A : F.args())
+        if (!Removed.count(A.getArgNo())) {
+          Args.push_back(CI->getArgOperand(A.getArgNo()));
+          ArgAttrs.push_back(Attrs.getParamAttrs(A.getArgNo()));
+        }
+
+      CallInst *New = CallInst::Create(Clone, Args, "", CI);
+      New->takeName(CI);
+      New->setAttributes(AttributeList::get(F.getContext(), Attrs.getFnAttrs(),
+                                            Attrs.getRetAttrs(), ArgAttrs));
+      New->setCallingConv(CI->getCallingConv());
+      New->setTailCallKind(CI->getTailCallKind());
+      New->setDebugLoc(CI->getDebugLoc());
+      CI->replaceAllUsesWith(New);
+      CI->eraseFromParent();
+    }
+  }
+
+  return !Hot.empty();
+}
+
+PreservedAnalyses IPConstProp::run(Module &M, ModuleAnalysisManager &AM) {
+  CallGraph &CG = AM.getResult<CallGraphAnalysis>(M);
+
+  // scc_iterator visita le SCC dai chiamati ai chiamanti: l'ordine viene
+  // invertito
+  std::vector<Function *> Order;
+  for (scc_iterator<CallGraph *> It = scc_begin(&CG); !It.isAtEnd(); ++It)
+    for (CallGraphNode *Node : *It)
+      if (Function *F = Node->getFunction())
+        if (!F->isDeclaration())
+          Order.push_back(F);
+  std::reverse(Order.begin(), Order.end());
+
+  SolverMap Solvers;
+  for (Function *F : Order) {
+    auto Solver = std::make_unique<SparseConstSolver>(*F);
+    seedArguments(*F, *Solver, Solvers);
+    Solver->solve();
+    Solvers[F] = std::move(Solver);
+  }
+
+  bool Changed = false;
+
+  // argomenti con lo stesso valore costante in tutte le chiamate
+  for (Function *F : Order)
+    for (Argument &A : F->args()) {
+      ConstLattice V = Solvers[F]->getValue(&A);
+      if (!V.isConstant() || A.use_empty())
+        continue;
+      outs() << "[IPConstProp]: " << F->getName() << ": arg" << A.getArgNo()
+             << " = " << *V.getConstant() << "\n";
+      A.replaceAllUsesWith(V.getConstant());
+      Changed = true;
+    }
+
+  // argomenti attuali che il chiamante calcola come costanti
+  for (Function *F : Order)
+    for (BasicBlock &BB : *F) {
+      if (!Solvers[F]->isExecutable(&BB))
+        continue;
+      for (Instruction &I : BB) {
+        auto *CB = dyn_cast<CallBase>(&I);
+        if (!CB)
+          continue;
+        for (unsigned Idx = 0; Idx < CB->arg_size(); ++Idx) {
+          if (isa<Constant>(CB->getArgOperand(Idx)))
+            continue;
+          if (Constant *C = getActualConstant(*CB, Idx, Solvers)) {
+            CB->setArgOperand(Idx, C);
+            Changed = true;
+          }
+        }
+      }
+    }
+
+  SmallVector<Function *, 4> Unused;
+  for (Function *F : Order)
+    if (specialize(*F, Solvers)) {
+      Changed = true;
+      if (F->hasLocalLinkage() && F->use_empty())
+        Unused.push_back(F);
+    }
+
+  Solvers.clear();
+  for (Function *F : Unused)
+    F->eraseFromParent();
+
+  if (!Changed)
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
@@ -0,0 +1,20 @@
+#ifndef LLVM_TRANSFORMS_IPCONSTPROP_H
+#define LLVM_TRANSFORMS_IPCONSTPROP_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+// Constant propagation interprocedurale: le funzioni vengono risolte con la
+// Sparse Conditional Constant Propagation seguendo le SCC del call graph dai
+// chiamanti ai chiamati, così i valori degli argomenti attuali sono già noti
+// quando si risolve il chiamato. Le funzioni chiamate con valori costanti
+// diversi vengono clonate e specializzate per i valori più frequenti
+class IPConstProp : public PassInfoMixin<IPConstProp> {
+public:
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_IPCONSTPROP_H
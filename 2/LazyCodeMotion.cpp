@@ -0,0 +1,267 @@
+#include "llvm/Transforms/Utils/LazyCodeMotion.h"
+#include "llvm/Transforms/Utils/DataflowAnalysis.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/SSAUpdater.h"
+
+using namespace llvm;
+
+// Fase della LCM: problema gen/kill sul dominio delle Very Busy Expressions
+// con insiemi Gen/Kill calcolati dalle fasi precedenti
+class LCMProblem : public DataflowProblem {
+public:
+  LCMProblem(StringRef Name, Direction Dir, MeetOp Meet,
+             const VeryBusyExpressions &VBE)
+      : DataflowProblem(Name, Dir, Meet), VBE(VBE) {
+    Universe = VBE.getUniverse();
+  }
+
+  void initialize(Function &F) override {}
+  void printFact(raw_ostream &OS, unsigned Idx) const override {
+    VBE.printFact(OS, Idx);
+  }
+
+  void setTransfer(const BasicBlock *BB, DataflowSet G, DataflowSet K) {
+    Gen[BB] = std::move(G);
+    Kill[BB] = std::move(K);
+  }
+
+private:
+  const VeryBusyExpressions &VBE;
+};
+
+struct LCMPlan {
+  BinaryOperator *Rep;
+  SmallVector<BasicBlock *, 4> Insert;
+  SmallVector<BinaryOperator *, 4> Replace;
+};
+
+// Come nel Dragon Book si inserisce un blocco su ogni arco che entra in un
+// blocco con più predecessori, così ogni punto di inserimento è l'inizio di
+// un blocco
+static SmallVector<BasicBlock *, 8> splitJoinEdges(Function &F) {
+  SmallVector<std::pair<BasicBlock *, BasicBlock *>, 8> Edges;
+  for (BasicBlock &BB : F) {
+    if (!BB.hasNPredecessorsOrMore(2) || BB.isEHPad())
+      continue;
+    SmallPtrSet<BasicBlock *, 4> Seen;
+    for (BasicBlock *Pred : predecessors(&BB)) {
+      Instruction *T = Pred->getTerminator();
+      if (isa<IndirectBrInst>(T) || isa<CallBrInst>(T))
+        continue;
+      if (Seen.insert(Pred).second)
+        Edges.push_back({Pred, &BB});
+    }
+  }
+
+  SmallVector<BasicBlock *, 8> Split;
+  for (auto &Edge : Edges)
+    if (BasicBlock *New = SplitEdge(Edge.first, Edge.second))
+      Split.push_back(New);
+  return Split;
+}
+
+static bool runLCMRound(Function &F) {
+  DominatorTree DT(F);
+
+  // 1. Anticipated Expressions (= Very Busy Expressions)
+  VeryBusyExpressions VBE;
+  DataflowSolver Anticipated(F, VBE);
+  Anticipated.solve();
+  unsigned Universe = VBE.getUniverse();
+  if (Universe == 0)
+    return false;
+
+  // 2. Available Expressions: out[b] = (anticipated.in[b] U in[b]) - kill_b
+  LCMProblem AvailP("Available Expressions", DataflowProblem::Forward,
+                    DataflowProblem::Intersection, VBE);
+  for (BasicBlock &BB : F) {
+    DataflowSet G = Anticipated.getIn(&BB);
+    G.subtract(VBE.getKill(&BB));
+    AvailP.setTransfer(&BB, G, VBE.getKill(&BB));
+  }
+  DataflowSolver Available(F, AvailP);
+  Available.solve();
+
+  // earliest[b] = anticipated.in[b] - available.in[b]
+  DenseMap<const BasicBlock *, DataflowSet> Earliest;
+  for (BasicBlock &BB : F) {
+    DataflowSet E = Anticipated.getIn(&BB);
+    E.subtract(Available.getIn(&BB));
+    Earliest[&BB] = E;
+  }
+
+  // 3. Postponable Expressions: out[b] = (earliest[b] U in[b]) - use_b
+  LCMProblem PostP("Postponable Expressions", DataflowProblem::Forward,
+                   DataflowProblem::Intersection, VBE);
+  for (BasicBlock &BB : F) {
+    DataflowSet G = Earliest[&BB];
+    G.subtract(VBE.getGen(&BB));
+    PostP.setTransfer(&BB, G, VBE.getGen(&BB));
+  }
+  DataflowSolver Postponable(F, PostP);
+  Postponable.solve();
+
+  // latest[b] = (earliest[b] U postponable.in[b]) ^
+  //             (use_b U not(^ succ s: earliest[s] U postponable.in[s]))
+  DenseMap<const BasicBlock *, DataflowSet> Latest;
+  for (BasicBlock &BB : F) {
+    DataflowSet Cand = Earliest[&BB];
+    Cand.unionWith(Postponable.getIn(&BB));
+
+    DataflowSet AllSucc(Universe, true);
+    for (BasicBlock *Succ : successors(&BB)) {
+      DataflowSet S = Earliest[Succ];
+      S.unionWith(Postponable.getIn(Succ));
+      AllSucc.intersectWith(S);
+    }
+    DataflowSet Limit(Universe, true);
+    Limit.subtract(AllSucc);
+    Limit.unionWith(VBE.getGen(&BB));
+
+    Cand.intersectWith(Limit);
+    Latest[&BB] = Cand;
+  }
+
+  // 4. Used Expressions: in[b] = (use_b U out[b]) - latest[b]
+  LCMProblem UsedP("Used Expressions", DataflowProblem::Backward,
+                   DataflowProblem::Union, VBE);
+  for (BasicBlock &BB : F) {
+    DataflowSet G = VBE.getGen(&BB);
+    G.subtract(Latest[&BB]);
+    UsedP.setTransfer(&BB, G, Latest[&BB]);
+  }
+  DataflowSolver Used(F, UsedP);
+  Used.solve();
+
+  // valutazioni upward-exposed di ciascuna espressione
+  std::vector<SmallVector<BinaryOperator *, 2>> Occurrences(Universe);
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB) {
+      int Expr = VBE.getExpression(&I);
+      if (Expr < 0 || !VBE.getGen(&BB).test(Expr))
+        continue;
+      bool Upward = true;
+      for (Value *Op : I.operands())
+        if (auto *OpI = dyn_cast<Instruction>(Op))
+          if (OpI->getParent() == &BB)
+            Upward = false;
+      if (Upward)
+        Occurrences[Expr].push_back(cast<BinaryOperator>(&I));
+    }
+
+  // inserimento di t = e all'inizio dei blocchi in latest ^ used.out,
+  // sostituzione delle valutazioni in use ^ (not latest U used.out)
+  std::vector<LCMPlan> Plans;
+  DenseSet<Instruction *> Replaced;
+  for (unsigned Expr = 0; Expr < Universe; ++Expr) {
+    LCMPlan Plan;
+    Plan.Rep = VBE.getRepresentative(Expr);
+    if (!isSafeToSpeculativelyExecute(Plan.Rep))
+      continue;
+
+    for (BasicBlock &BB : F)
+      if (Latest[&BB].test(Expr) && Used.getOut(&BB).test(Expr))
+        Plan.Insert.push_back(&BB);
+
+    for (BinaryOperator *Occ : Occurrences[Expr]) {
+      BasicBlock *BB = Occ->getParent();
+      if (!Latest[BB].test(Expr) || Used.getOut(BB).test(Expr))
+        Plan.Replace.push_back(Occ);
+    }
+
+    if (Plan.Replace.empty())
+      continue;
+
+    // un solo inserimento nello stesso blocco delle valutazioni non cambia
+    // nulla
+    if (Plan.Insert.size() == 1 &&
+        all_of(Plan.Replace, [&](BinaryOperator *Occ) {
+          return Occ->getParent() == Plan.Insert.front();
+        }))
+      continue;
+
+    bool Dominated = all_of(Plan.Insert, [&](BasicBlock *BB) {
+      return all_of(Plan.Rep->operands(), [&](Value *Op) {
+        auto *OpI = dyn_cast<Instruction>(Op);
+        return !OpI || DT.dominates(OpI, &*BB->getFirstInsertionPt());
+      });
+    });
+    if (!Dominated)
+      continue;
+
+    Replaced.insert(Plan.Replace.begin(), Plan.Replace.end());
+    Plans.push_back(std::move(Plan));
+  }
+
+  // gli operandi verranno sostituiti in questo giro: l'espressione sarà
+  // trattata al giro successivo
+  erase_if(Plans, [&](LCMPlan &Plan) {
+    return any_of(Plan.Rep->operands(), [&](Value *Op) {
+      auto *OpI = dyn_cast<Instruction>(Op);
+      return OpI && Replaced.count(OpI);
+    });
+  });
+
+  for (LCMPlan &Plan : Plans) {
+    SSAUpdater SSA;
+    SSA.Initialize(Plan.Rep->getType(), Plan.Rep->getName());
+    DenseMap<BasicBlock *, Instruction *> Inserted;
+    for (BasicBlock *BB : Plan.Insert) {
+      Instruction *T = Plan.Rep->clone();
+      T->setName(Plan.Rep->getName() + ".lcm");
+      T->insertBefore(&*BB->getFirstInsertionPt());
+      for (BinaryOperator *Occ : Plan.Replace)
+        T->andIRFlags(Occ);
+      SSA.AddAvailableValue(BB, T);
+      Inserted[BB] = T;
+    }
+
+    outs() << "[LazyCodeMotion]: " << *Plan.Rep << " inserita in "
+           << Plan.Insert.size() << " blocchi, sostituite "
+           << Plan.Replace.size() << " valutazioni\n";
+
+    for (BinaryOperator *Occ : Plan.Replace) {
+      BasicBlock *BB = Occ->getParent();
+      auto It = Inserted.find(BB);
+      Value *V = It != Inserted.end() ? It->second
+                                      : SSA.GetValueInMiddleOfBlock(BB);
+      Occ->replaceAllUsesWith(V);
+      Occ->eraseFromParent();
+    }
+  }
+
+  return !Plans.empty();
+}
+
+PreservedAnalyses LazyCodeMotion::run(Function &F,
+                                      FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  bool Changed = removeUnreachableBlocks(F);
+  SmallVector<BasicBlock *, 8> Split = splitJoinEdges(F);
+  Changed |= !Split.empty();
+
+  // le espressioni che usano valori sostituiti vengono trattate nei giri
+  // successivi, con il problema risolto sul codice aggiornato
+  while (runLCMRound(F))
+    Changed = true;
+
+  // i blocchi inseriti sugli archi vengono eliminati se rimasti vuoti, o
+  // fusi nel predecessore quando l'arco non era critico
+  for (BasicBlock *BB : Split) {
+    if (BB->size() == 1)
+      TryToSimplifyUncondBranchFromEmptyBlock(BB);
+    else
+      MergeBlockIntoPredecessor(BB);
+  }
+
+  if (!Changed)
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
@@ -0,0 +1,19 @@
+#ifndef LLVM_TRANSFORMS_LAZYCODEMOTION_H
+#define LLVM_TRANSFORMS_LAZYCODEMOTION_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+// Partial Redundancy Elimination con Lazy Code Motion: le espressioni vengono
+// calcolate il più tardi possibile tra i punti in cui sono anticipate e non
+// ancora disponibili, eliminando le valutazioni ridondanti anche solo su
+// alcuni cammini
+class LazyCodeMotion : public PassInfoMixin<LazyCodeMotion> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_LAZYCODEMOTION_H
@@ -0,0 +1,294 @@
+#include "llvm/Transforms/Utils/RangeAnalysis.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+
+using namespace llvm;
+
+// aggiornamenti di una PHI prima di applicare il widening
+static const unsigned WideningThreshold = 3;
+
+ConstantRange RangeSolver::getRange(Value *V) const {
+  unsigned Width = V->getType()->getIntegerBitWidth();
+  if (auto *CI = dyn_cast<ConstantInt>(V))
+    return ConstantRange(CI->getValue());
+  // undef può assumere qualsiasi valore, anche diverso a ogni uso: come
+  // top una PHI ignorerebbe il percorso da cui arriva, che può portare un
+  // valore negativo in una sdiv trasformata in udiv
+  if (isa<Constant>(V))
+    return ConstantRange::getFull(Width);
+
+  auto It = Ranges.find(V);
+  if (It != Ranges.end())
+    return It->second;
+
+  // istruzioni non ancora valutate durante la soluzione; dopo, argomenti e
+  // istruzioni aggiunte non sono noti
+  if (isa<Instruction>(V) && !Solved)
+    return ConstantRange::getEmpty(Width);
+  return ConstantRange::getFull(Width);
+}
+
+bool RangeSolver::isNonNegative(Value *V) const {
+  if (!V->getType()->isIntegerTy())
+    return false;
+  ConstantRange R = getRange(V);
+  return !R.isEmptySet() && R.isAllNonNegative();
+}
+
+ConstantRange RangeSolver::evaluate(Instruction &I) const {
+  unsigned Width = I.getType()->getIntegerBitWidth();
+  ConstantRange Full = ConstantRange::getFull(Width);
+
+  if (auto *PN = dyn_cast<PHINode>(&I)) {
+    ConstantRange Result = ConstantRange::getEmpty(Width);
+    for (unsigned Idx = 0; Idx < PN->getNumIncomingValues(); ++Idx)
+      if (Reachable.count(PN->getIncomingBlock(Idx)))
+        Result = Result.unionWith(getRange(PN->getIncomingValue(Idx)),
+                                  ConstantRange::Signed);
+    return Result;
+  }
+
+  if (MDNode *MD = I.getMetadata(LLVMContext::MD_range))
+    return getConstantRangeFromMetadata(*MD);
+
+  // con un operando ancora top si aspetta la sua valutazione
+  for (Value *Op : I.operands())
+    if (Op->getType()->isIntegerTy() && getRange(Op).isEmptySet())
+      return ConstantRange::getEmpty(Width);
+
+  if (auto *BO = dyn_cast<BinaryOperator>(&I)) {
+    ConstantRange L = getRange(BO->getOperand(0));
+    ConstantRange R = getRange(BO->getOperand(1));
+    if (auto *OBO = dyn_cast<OverflowingBinaryOperator>(BO)) {
+      unsigned NoWrap = 0;
+      if (OBO->hasNoSignedWrap())
+        NoWrap |= OverflowingBinaryOperator::NoSignedWrap;
+      if (OBO->hasNoUnsignedWrap())
+        NoWrap |= OverflowingBinaryOperator::NoUnsignedWrap;
+      if (NoWrap)
+        return L.overflowingBinaryOp(BO->getOpcode(), R, NoWrap);
+    }
+    return L.binaryOp(BO->getOpcode(), R);
+  }
+
+  if (auto *CI = dyn_cast<CastInst>(&I)) {
+    if (!CI->getSrcTy()->isIntegerTy())
+      return Full;
+    return getRange(CI->getOperand(0)).castOp(CI->getOpcode(), Width);
+  }
+
+  if (auto *Cmp = dyn_cast<ICmpInst>(&I)) {
+    if (!Cmp->getOperand(0)->getType()->isIntegerTy())
+      return Full;
+    ConstantRange L = getRange(Cmp->getOperand(0));
+    ConstantRange R = getRange(Cmp->getOperand(1));
+    if (L.icmp(Cmp->getPredicate(), R))
+      return ConstantRange(APInt(1, 1));
+    if (L.icmp(Cmp->getInversePredicate(), R))
+      return ConstantRange(APInt(1, 0));
+    return Full;
+  }
+
+  if (auto *SI = dyn_cast<SelectInst>(&I)) {
+    ConstantRange Cond = getRange(SI->getCondition());
+    if (const APInt *C = Cond.getSingleElement())
+      return getRange(C->isOne() ? SI->getTrueValue() : SI->getFalseValue());
+    return getRange(SI->getTrueValue())
+        .unionWith(getRange(SI->getFalseValue()), ConstantRange::Signed);
+  }
+
+  // memoria, chiamate e altre istruzioni non vengono valutate
+  return Full;
+}
+
+void RangeSolver::update(Instruction &I, const ConstantRange &R) {
+  unsigned Width = I.getType()->getIntegerBitWidth();
+  auto It = Ranges.try_emplace(&I, ConstantRange::getEmpty(Width)).first;
+  ConstantRange Old = It->second;
+  ConstantRange New = Old.unionWith(R, ConstantRange::Signed);
+  if (New == Old)
+    return;
+
+  // una PHI che cambia ancora dopo WideningThreshold aggiornamenti sta
+  // crescendo lungo un ciclo: l'estremo che si muove va al limite del tipo
+  if (isa<PHINode>(I) && ++Updates[&I] > WideningThreshold &&
+      !Old.isEmptySet()) {
+    APInt Lower = Old.getSignedMin();
+    APInt Upper = Old.getSignedMax();
+    if (New.getSignedMin().slt(Lower))
+      Lower = APInt::getSignedMinValue(Width);
+    if (New.getSignedMax().sgt(Upper))
+      Upper = APInt::getSignedMaxValue(Width);
+    New = ConstantRange::getNonEmpty(Lower, Upper + 1);
+  }
+  It->second = New;
+
+  for (User *U : I.users())
+    if (auto *UI = dyn_cast<Instruction>(U))
+      if (Reachable.count(UI->getParent()))
+        Worklist.push_back(UI);
+}
+
+void RangeSolver::visit(Instruction &I) {
+  if (I.getType()->isIntegerTy())
+    update(I, evaluate(I));
+}
+
+void RangeSolver::solve() {
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *BB : RPOT)
+    Reachable.insert(BB);
+
+  // prima visita in reverse post-order, poi solo le catene def-use dei
+  // valori cambiati
+  for (BasicBlock *BB : RPOT)
+    for (Instruction &I : *BB)
+      visit(I);
+
+  while (!Worklist.empty()) {
+    Instruction *I = Worklist.back();
+    Worklist.pop_back();
+    visit(*I);
+  }
+  Solved = true;
+}
+
+//===----------------------------------------------------------------------===//
+// Trasformazioni
+//===----------------------------------------------------------------------===//
+
+static bool neverOverflows(Instruction::BinaryOps Op, bool Signed,
+                           const ConstantRange &L, const ConstantRange &R) {
+  // operandi rimasti top (calcolati solo da cicli di PHI senza valore
+  // iniziale): non c'è nessun intervallo da cui dedurre il flag
+  if (L.isEmptySet() || R.isEmptySet())
+    return false;
+
+  ConstantRange::OverflowResult Result;
+  switch (Op) {
+  case Instruction::Add:
+    Result = Signed ? L.signedAddMayOverflow(R) : L.unsignedAddMayOverflow(R);
+    break;
+  case Instruction::Sub:
+    Result = Signed ? L.signedSubMayOverflow(R) : L.unsignedSubMayOverflow(R);
+    break;
+  case Instruction::Mul:
+    if (Signed)
+      return false;
+    Result = L.unsignedMulMayOverflow(R);
+    break;
+  default:
+    return false;
+  }
+  return Result == ConstantRange::OverflowResult::NeverOverflows;
+}
+
+// udiv/urem su un tipo più stretto quando entrambi gli operandi ci stanno
+static bool narrowDivision(BinaryOperator &BO, const RangeSolver &Solver) {
+  unsigned Width = BO.getType()->getIntegerBitWidth();
+  unsigned Needed =
+      std::max(Solver.getRange(BO.getOperand(0)).getUnsignedMax().getActiveBits(),
+               Solver.getRange(BO.getOperand(1)).getUnsignedMax().getActiveBits());
+  unsigned NewWidth = std::max<unsigned>(8, PowerOf2Ceil(Needed));
+  if (NewWidth >= Width)
+    return false;
+
+  Type *NewTy = IntegerType::get(BO.getContext(), NewWidth);
+  auto *L = CastInst::Create(Instruction::Trunc, BO.getOperand(0), NewTy,
+                             BO.getName() + ".lhs", &BO);
+  auto *R = CastInst::Create(Instruction::Trunc, BO.getOperand(1), NewTy,
+                             BO.getName() + ".rhs", &BO);
+  auto *Narrow = BinaryOperator::Create(BO.getOpcode(), L, R, BO.getName(), &BO);
+  if (isa<PossiblyExactOperator>(BO))
+    Narrow->setIsExact(BO.isExact());
+  auto *Ext = CastInst::Create(Instruction::ZExt, Narrow, BO.getType(),
+                               BO.getName() + ".zext", &BO);
+
+  outs() << "[RangePropagation]: " << BO << " -> " << *Narrow << " su i"
+         << NewWidth << "\n";
+  BO.replaceAllUsesWith(Ext);
+  return true;
+}
+
+PreservedAnalyses RangePropagation::run(Function &F,
+                                        FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  RangeSolver Solver(F);
+  Solver.solve();
+
+  // le istruzioni sostituite si cancellano alla fine: gli intervalli sono
+  // indicizzati per puntatore
+  SmallVector<Instruction *, 8> Dead;
+  bool Changed = false;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB) {
+      // sext di un valore non negativo = zext
+      if (auto *SE = dyn_cast<SExtInst>(&I)) {
+        if (!Solver.isNonNegative(SE->getOperand(0)))
+          continue;
+        outs() << "[RangePropagation]: " << *SE << " -> zext\n";
+        auto *ZE = new ZExtInst(SE->getOperand(0), SE->getType(), "", SE);
+        ZE->takeName(SE);
+        SE->replaceAllUsesWith(ZE);
+        Dead.push_back(SE);
+        continue;
+      }
+
+      // controllo di overflow che non può mai scattare
+      if (auto *WO = dyn_cast<WithOverflowInst>(&I)) {
+        if (!neverOverflows(WO->getBinaryOp(), WO->isSigned(),
+                            Solver.getRange(WO->getLHS()),
+                            Solver.getRange(WO->getRHS())))
+          continue;
+        for (User *U : make_early_inc_range(WO->users()))
+          if (auto *EV = dyn_cast<ExtractValueInst>(U))
+            if (EV->getIndices()[0] == 1) {
+              outs() << "[RangePropagation]: " << *WO
+                     << " - overflow impossibile\n";
+              EV->replaceAllUsesWith(ConstantInt::getFalse(F.getContext()));
+              Dead.push_back(EV);
+            }
+        continue;
+      }
+
+      auto *BO = dyn_cast<BinaryOperator>(&I);
+      if (!BO || !BO->getType()->isIntegerTy())
+        continue;
+
+      if (BO->getOpcode() == Instruction::UDiv ||
+          BO->getOpcode() == Instruction::URem) {
+        if (narrowDivision(*BO, Solver))
+          Dead.push_back(BO);
+        continue;
+      }
+
+      if (!isa<OverflowingBinaryOperator>(BO))
+        continue;
+      ConstantRange L = Solver.getRange(BO->getOperand(0));
+      ConstantRange R = Solver.getRange(BO->getOperand(1));
+      bool NSW = !BO->hasNoSignedWrap() &&
+                 neverOverflows(BO->getOpcode(), true, L, R);
+      bool NUW = !BO->hasNoUnsignedWrap() &&
+                 neverOverflows(BO->getOpcode(), false, L, R);
+      if (!NSW && !NUW)
+        continue;
+      if (NSW)
+        BO->setHasNoSignedWrap(true);
+      if (NUW)
+        BO->setHasNoUnsignedWrap(true);
+      outs() << "[RangePropagation]: " << *BO << " - overflow impossibile\n";
+      Changed = true;
+    }
+
+  for (Instruction *I : Dead)
+    I->eraseFromParent();
+
+  if (!Changed && Dead.empty())
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
@@ -0,0 +1,50 @@
+#ifndef LLVM_TRANSFORMS_RANGEANALYSIS_H
+#define LLVM_TRANSFORMS_RANGEANALYSIS_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/ConstantRange.h"
+#include <vector>
+
+namespace llvm {
+
+// Estensione della constant propagation al reticolo degli intervalli: ogni
+// valore intero SSA ha un intervallo di valori possibili (vuoto = top,
+// pieno = bottom) e il meet è l'unione. Le PHI che continuano a crescere
+// lungo un ciclo vengono allargate (widening) fino all'estremo del tipo, così
+// la soluzione termina anche per gli indici dei loop
+class RangeSolver {
+public:
+  explicit RangeSolver(Function &F) : F(F) {}
+
+  void solve();
+
+  // dopo solve: intervallo pieno per i valori non analizzati
+  ConstantRange getRange(Value *V) const;
+  bool isNonNegative(Value *V) const;
+
+private:
+  ConstantRange evaluate(Instruction &I) const;
+  void visit(Instruction &I);
+  void update(Instruction &I, const ConstantRange &R);
+
+  Function &F;
+  bool Solved = false;
+  DenseMap<Value *, ConstantRange> Ranges;
+  DenseMap<Value *, unsigned> Updates;
+  DenseSet<const BasicBlock *> Reachable;
+  std::vector<Instruction *> Worklist;
+};
+
+// Usa gli intervalli per convertire le operazioni signed in unsigned,
+// aggiungere i flag nsw/nuw, eliminare i controlli di overflow sempre falsi
+// e restringere il tipo delle divisioni
+class RangePropagation : public PassInfoMixin<RangePropagation> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_RANGEANALYSIS_H
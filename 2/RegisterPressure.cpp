@@ -0,0 +1,157 @@
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include "llvm/Transforms/Utils/DataflowAnalysis.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/IR/CFG.h"
+
+using namespace llvm;
+
+AnalysisKey RegisterPressureAnalysis::Key;
+
+// Per ogni blocco si parte dai valori vivi in uscita e si risale il blocco:
+// una definizione toglie il valore dall'insieme, gli operandi lo aggiungono.
+// La pressione è il massimo numero di valori vivi per classe tra tutti i
+// punti del blocco
+RegisterPressure::RegisterPressure(Function &F,
+                                   const TargetTransformInfo &TTI)
+    : TTI(&TTI) {
+  Liveness LV;
+  DataflowSolver Solver(F, LV);
+  Solver.solve();
+
+  std::vector<unsigned> ValueClass(LV.getUniverse());
+  unsigned NumClasses = 0;
+  for (unsigned Idx = 0; Idx < LV.getUniverse(); ++Idx) {
+    unsigned ClassID = getRegisterClass(LV.getValue(Idx)->getType());
+    ValueClass[Idx] = ClassID;
+    NumClasses = std::max(NumClasses, ClassID + 1);
+    if (!is_contained(Classes, ClassID))
+      Classes.push_back(ClassID);
+  }
+  llvm::sort(Classes);
+
+  for (BasicBlock *BB : depth_first(&F.getEntryBlock())) {
+    BlockPressure &BP = Blocks[BB];
+    BP.Max.assign(NumClasses, 0);
+    BP.LiveIn.assign(NumClasses, 0);
+    Solver.getIn(BB).forEach(
+        [&](unsigned Idx) { ++BP.LiveIn[ValueClass[Idx]]; });
+
+    // gli operandi delle PHI dei successori sono vivi all'uscita di BB
+    DataflowSet Live = Solver.getOut(BB);
+    for (BasicBlock *Succ : successors(BB))
+      for (PHINode &Phi : Succ->phis())
+        for (unsigned In = 0; In < Phi.getNumIncomingValues(); ++In) {
+          int Idx = LV.getValueIndex(Phi.getIncomingValue(In));
+          if (Phi.getIncomingBlock(In) == BB && Idx >= 0)
+            Live.insert(Idx);
+        }
+
+    SmallVector<unsigned, 2> Current(NumClasses, 0);
+    Live.forEach([&](unsigned Idx) { ++Current[ValueClass[Idx]]; });
+    BP.Max = Current;
+
+    for (Instruction &I : reverse(*BB)) {
+      if (isa<PHINode>(I))
+        break;
+
+      int Def = LV.getValueIndex(&I);
+      if (Def >= 0) {
+        unsigned ClassID = ValueClass[Def];
+        // un valore mai usato occupa comunque un registro quando è definito
+        if (!Live.erase(Def))
+          BP.Max[ClassID] = std::max(BP.Max[ClassID], Current[ClassID] + 1);
+        else
+          --Current[ClassID];
+      }
+
+      for (Value *Op : I.operands()) {
+        int Idx = LV.getValueIndex(Op);
+        if (Idx >= 0 && Live.insert(Idx))
+          ++Current[ValueClass[Idx]];
+      }
+
+      for (unsigned ClassID = 0; ClassID < NumClasses; ++ClassID)
+        BP.Max[ClassID] = std::max(BP.Max[ClassID], Current[ClassID]);
+    }
+  }
+}
+
+unsigned RegisterPressure::getRegisterClass(Type *Ty) const {
+  return TTI->getRegisterClassForType(Ty->isVectorTy(), Ty);
+}
+
+unsigned RegisterPressure::getNumRegisters(unsigned ClassID) const {
+  return TTI->getNumberOfRegisters(ClassID);
+}
+
+unsigned RegisterPressure::getMaxPressure(const BasicBlock *BB,
+                                          unsigned ClassID) const {
+  auto It = Blocks.find(BB);
+  if (It == Blocks.end() || ClassID >= It->second.Max.size())
+    return 0;
+  return It->second.Max[ClassID];
+}
+
+unsigned RegisterPressure::getMaxPressure(ArrayRef<BasicBlock *> BBs,
+                                          unsigned ClassID) const {
+  unsigned Max = 0;
+  for (BasicBlock *BB : BBs)
+    Max = std::max(Max, getMaxPressure(BB, ClassID));
+  return Max;
+}
+
+unsigned RegisterPressure::getLiveIn(const BasicBlock *BB,
+                                     unsigned ClassID) const {
+  auto It = Blocks.find(BB);
+  if (It == Blocks.end() || ClassID >= It->second.LiveIn.size())
+    return 0;
+  return It->second.LiveIn[ClassID];
+}
+
+unsigned RegisterPressure::getFreeRegisters(ArrayRef<BasicBlock *> BBs,
+                                            unsigned ClassID) const {
+  unsigned Regs = getNumRegisters(ClassID);
+  unsigned Used = getMaxPressure(BBs, ClassID);
+  return Used >= Regs ? 0 : Regs - Used;
+}
+
+void RegisterPressure::print(raw_ostream &OS, Function &F) const {
+  OS << "[RegisterPressure]: " << F.getName() << "\n";
+  for (unsigned ClassID : Classes)
+    OS << "  classe " << TTI->getRegisterClassName(ClassID) << ": "
+       << getNumRegisters(ClassID) << " registri\n";
+
+  for (BasicBlock &BB : F) {
+    if (!Blocks.count(&BB))
+      continue;
+    BB.printAsOperand(OS, false);
+    OS << ":";
+    for (unsigned ClassID : Classes) {
+      unsigned Max = getMaxPressure(&BB, ClassID);
+      OS << " " << TTI->getRegisterClassName(ClassID) << " = " << Max;
+      if (Max > getNumRegisters(ClassID))
+        OS << " (spill)";
+    }
+    OS << "\n";
+  }
+  OS << "\n";
+}
+
+RegisterPressure RegisterPressureAnalysis::run(Function &F,
+                                               FunctionAnalysisManager &AM) {
+  return RegisterPressure(F, AM.getResult<TargetIRAnalysis>(F));
+}
+
+PreservedAnalyses RegisterPressurePrinter::run(Function &F,
+                                               FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  Liveness LV;
+  DataflowSolver Solver(F, LV);
+  Solver.solve();
+  Solver.print(outs());
+
+  AM.getResult<RegisterPressureAnalysis>(F).print(outs(), F);
+  return PreservedAnalyses::all();
+}
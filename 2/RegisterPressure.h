@@ -0,0 +1,66 @@
+#ifndef LLVM_TRANSFORMS_REGISTERPRESSURE_H
+#define LLVM_TRANSFORMS_REGISTERPRESSURE_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+
+namespace llvm {
+
+// Stima della pressione sui registri a partire dalla Liveness: per ogni
+// blocco e classe di registro il massimo numero di valori vivi insieme, da
+// confrontare con i registri della classe secondo TargetTransformInfo.
+// Serve alle trasformazioni che allungano la vita dei valori (hoisting,
+// fusione di loop, sequenze shift+add/sub) per evitare di introdurre spill
+class RegisterPressure {
+public:
+  RegisterPressure(Function &F, const TargetTransformInfo &TTI);
+
+  unsigned getRegisterClass(Type *Ty) const;
+  unsigned getNumRegisters(unsigned ClassID) const;
+  // classi dei valori presenti nella funzione
+  ArrayRef<unsigned> getRegisterClasses() const { return Classes; }
+
+  unsigned getMaxPressure(const BasicBlock *BB, unsigned ClassID) const;
+  unsigned getMaxPressure(ArrayRef<BasicBlock *> Blocks,
+                          unsigned ClassID) const;
+  // valori vivi all'ingresso del blocco; per l'header di un loop sono quelli
+  // che restano vivi per tutto il loop
+  unsigned getLiveIn(const BasicBlock *BB, unsigned ClassID) const;
+  // registri della classe ancora liberi nel punto peggiore dei blocchi
+  unsigned getFreeRegisters(ArrayRef<BasicBlock *> Blocks,
+                            unsigned ClassID) const;
+
+  void print(raw_ostream &OS, Function &F) const;
+
+private:
+  struct BlockPressure {
+    SmallVector<unsigned, 2> Max;
+    SmallVector<unsigned, 2> LiveIn;
+  };
+
+  const TargetTransformInfo *TTI;
+  SmallVector<unsigned, 2> Classes;
+  DenseMap<const BasicBlock *, BlockPressure> Blocks;
+};
+
+class RegisterPressureAnalysis
+    : public AnalysisInfoMixin<RegisterPressureAnalysis> {
+  friend AnalysisInfoMixin<RegisterPressureAnalysis>;
+  static AnalysisKey Key;
+
+public:
+  using Result = RegisterPressure;
+  Result run(Function &F, FunctionAnalysisManager &AM);
+};
+
+// Stampa Liveness e pressione sui registri di ogni blocco
+class RegisterPressurePrinter : public PassInfoMixin<RegisterPressurePrinter> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_REGISTERPRESSURE_H
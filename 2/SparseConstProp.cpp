@@ -0,0 +1,293 @@
+#include "llvm/Transforms/Utils/SparseConstProp.h"
+#include "llvm/Transforms/Utils/LocalOpts.h"
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include "llvm/Transforms/Utils/RangeAnalysis.h"
+#include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+using namespace llvm;
+
+bool ConstLattice::meet(const ConstLattice &Other) {
+  if (isBottom() || Other.isTop())
+    return false;
+
+  if (isTop()) {
+    *this = Other;
+    return true;
+  }
+
+  if (Other.isBottom() || Other.C != C) {
+    *this = getBottom();
+    return true;
+  }
+  return false;
+}
+
+void SparseConstSolver::setArgument(Argument *A, Constant *C) {
+  Values[A] = ConstLattice::getConstant(C);
+}
+
+ConstLattice SparseConstSolver::getValue(Value *V) const {
+  // undef può assumere qualsiasi valore: viene trattato come top
+  if (isa<UndefValue>(V))
+    return ConstLattice();
+  if (auto *C = dyn_cast<Constant>(V))
+    return ConstLattice::getConstant(C);
+
+  auto It = Values.find(V);
+  if (It != Values.end())
+    return It->second;
+
+  // argomenti senza seme e altri valori non istruzione non sono noti
+  if (!isa<Instruction>(V))
+    return ConstLattice::getBottom();
+  return ConstLattice();
+}
+
+void SparseConstSolver::update(Instruction &I, const ConstLattice &V) {
+  ConstLattice &Old = Values[&I];
+  if (!Old.meet(V))
+    return;
+
+  for (User *U : I.users())
+    if (auto *UI = dyn_cast<Instruction>(U))
+      if (ExecBlocks.count(UI->getParent()))
+        InstWorklist.push_back(UI);
+}
+
+void SparseConstSolver::markEdge(BasicBlock *From, BasicBlock *To) {
+  if (!ExecEdges.insert({From, To}).second)
+    return;
+
+  // primo arco entrante: si visita tutto il blocco, altrimenti solo le PHI
+  if (ExecBlocks.insert(To).second) {
+    BlockWorklist.push_back(To);
+  } else {
+    for (PHINode &PN : To->phis())
+      InstWorklist.push_back(&PN);
+  }
+}
+
+void SparseConstSolver::visitPHI(PHINode &PN) {
+  ConstLattice Result;
+  for (unsigned Idx = 0; Idx < PN.getNumIncomingValues(); ++Idx)
+    if (isEdgeExecutable(PN.getIncomingBlock(Idx), PN.getParent()))
+      Result.meet(getValue(PN.getIncomingValue(Idx)));
+  update(PN, Result);
+}
+
+void SparseConstSolver::visitTerminator(Instruction &I) {
+  BasicBlock *BB = I.getParent();
+
+  if (auto *BI = dyn_cast<BranchInst>(&I)) {
+    if (BI->isUnconditional()) {
+      markEdge(BB, BI->getSuccessor(0));
+      return;
+    }
+
+    ConstLattice Cond = getValue(BI->getCondition());
+    if (Cond.isTop())
+      return;
+    if (auto *CI = dyn_cast_or_null<ConstantInt>(Cond.getConstant())) {
+      markEdge(BB, BI->getSuccessor(CI->isOne() ? 0 : 1));
+      return;
+    }
+  } else if (auto *SI = dyn_cast<SwitchInst>(&I)) {
+    ConstLattice Cond = getValue(SI->getCondition());
+    if (Cond.isTop())
+      return;
+    if (auto *CI = dyn_cast_or_null<ConstantInt>(Cond.getConstant())) {
+      markEdge(BB, SI->findCaseValue(CI)->getCaseSuccessor());
+      return;
+    }
+  }
+
+  // condizione non costante o altri terminatori: tutti gli archi eseguibili
+  for (BasicBlock *Succ : successors(BB))
+    markEdge(BB, Succ);
+}
+
+void SparseConstSolver::visit(Instruction &I) {
+  if (auto *PN = dyn_cast<PHINode>(&I)) {
+    visitPHI(*PN);
+    return;
+  }
+
+  if (I.isTerminator()) {
+    visitTerminator(I);
+    if (!I.getType()->isVoidTy())
+      update(I, ConstLattice::getBottom());
+    return;
+  }
+
+  if (I.getType()->isVoidTy())
+    return;
+
+  // accessi in memoria, chiamate e allocazioni non vengono valutati
+  if (I.mayReadOrWriteMemory() || I.mayHaveSideEffects() || isa<CallBase>(I) ||
+      isa<AllocaInst>(I) || I.isEHPad()) {
+    update(I, ConstLattice::getBottom());
+    return;
+  }
+
+  // un solo operando bottom rende bottom il risultato, anche se un altro
+  // operando è undef: and undef, %y non è una costante se %y non lo è
+  for (Value *Op : I.operands())
+    if (getValue(Op).isBottom()) {
+      update(I, ConstLattice::getBottom());
+      return;
+    }
+
+  // gli operandi undef si passano al folding, che sceglie un valore valido
+  // (and undef, 5 -> 0); si aspetta solo sulle istruzioni non ancora valutate
+  SmallVector<Constant *, 4> Ops;
+  for (Value *Op : I.operands()) {
+    ConstLattice V = getValue(Op);
+    if (V.isTop() && !isa<UndefValue>(Op))
+      return;
+    Ops.push_back(V.isTop() ? cast<Constant>(Op) : V.getConstant());
+  }
+
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  Constant *C = nullptr;
+  if (auto *CI = dyn_cast<CmpInst>(&I))
+    C = ConstantFoldCompareInstOperands(CI->getPredicate(), Ops[0], Ops[1], DL);
+  else
+    C = ConstantFoldInstOperands(&I, Ops, DL);
+
+  update(I, C ? ConstLattice::getConstant(C) : ConstLattice::getBottom());
+}
+
+// Un branch su una condizione rimasta top non renderebbe mai eseguibili i
+// successori: si considerano eseguibili tutti gli archi
+bool SparseConstSolver::resolveUndefBranches() {
+  bool Changed = false;
+  for (BasicBlock &BB : F) {
+    if (!isExecutable(&BB))
+      continue;
+
+    Instruction *T = BB.getTerminator();
+    Value *Cond = nullptr;
+    if (auto *BI = dyn_cast<BranchInst>(T)) {
+      if (BI->isConditional())
+        Cond = BI->getCondition();
+    } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
+      Cond = SI->getCondition();
+    }
+
+    if (!Cond || !getValue(Cond).isTop())
+      continue;
+
+    for (BasicBlock *Succ : successors(&BB))
+      if (!isEdgeExecutable(&BB, Succ)) {
+        markEdge(&BB, Succ);
+        Changed = true;
+      }
+  }
+  return Changed;
+}
+
+void SparseConstSolver::solve() {
+  BasicBlock *Entry = &F.getEntryBlock();
+  ExecBlocks.insert(Entry);
+  BlockWorklist.push_back(Entry);
+
+  do {
+    while (!BlockWorklist.empty() || !InstWorklist.empty()) {
+      // prima si esauriscono le catene def-use, poi i nuovi blocchi
+      while (!InstWorklist.empty()) {
+        Instruction *I = InstWorklist.back();
+        InstWorklist.pop_back();
+        if (isExecutable(I->getParent()))
+          visit(*I);
+      }
+
+      if (!BlockWorklist.empty()) {
+        BasicBlock *BB = BlockWorklist.back();
+        BlockWorklist.pop_back();
+        for (Instruction &I : *BB)
+          visit(I);
+      }
+    }
+  } while (resolveUndefBranches());
+}
+
+bool SparseConstSolver::rewrite() {
+  bool Changed = false;
+
+  for (Argument &A : F.args()) {
+    auto It = Values.find(&A);
+    if (It != Values.end() && It->second.isConstant() && !A.use_empty()) {
+      A.replaceAllUsesWith(It->second.getConstant());
+      Changed = true;
+    }
+  }
+
+  for (BasicBlock &BB : F) {
+    if (!isExecutable(&BB))
+      continue;
+
+    for (Instruction &I : make_early_inc_range(BB)) {
+      if (I.isTerminator() || I.getType()->isVoidTy())
+        continue;
+      ConstLattice V = getValue(&I);
+      if (!V.isConstant())
+        continue;
+
+      outs() << "[SparseConstProp]: " << I << " -> " << *V.getConstant() << "\n";
+      I.replaceAllUsesWith(V.getConstant());
+      if (isInstructionTriviallyDead(&I))
+        I.eraseFromParent();
+      Changed = true;
+    }
+
+    // le condizioni costanti sono state sostituite: il branch diventa
+    // incondizionato verso l'unico successore eseguibile
+    Changed |= ConstantFoldTerminator(&BB, true);
+  }
+
+  SmallVector<BasicBlock *, 8> Dead;
+  for (BasicBlock &BB : F)
+    if (!isExecutable(&BB))
+      Dead.push_back(&BB);
+
+  if (!Dead.empty()) {
+    outs() << "[SparseConstProp]: rimossi " << Dead.size()
+           << " blocchi non eseguibili\n";
+    DeleteDeadBlocks(Dead);
+    Changed = true;
+  }
+
+  return Changed;
+}
+
+PreservedAnalyses SparseConstProp::run(Function &F,
+                                       FunctionAnalysisManager &AM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  SparseConstSolver Solver(F);
+  Solver.solve();
+  if (!Solver.rewrite())
+    return PreservedAnalyses::all();
+
+  // le costanti propagate diventano operandi immediati per i peephole
+  // di LocalOpts; le sequenze shift+add/sub solo dove c'è un registro libero,
+  // le sdiv diventano lshr/udiv sugli operandi con intervallo non negativo
+  RegisterPressure RP(F, AM.getResult<TargetIRAnalysis>(F));
+  unsigned ScalarClass = RP.getRegisterClass(Type::getInt32Ty(F.getContext()));
+  RangeSolver Ranges(F);
+  Ranges.solve();
+  auto IsNonNegative = [&](Value *V) { return Ranges.isNonNegative(V); };
+  for (BasicBlock &BB : F) {
+    BasicBlock *Block = &BB;
+    runOnAlgebraicIdentity(BB);
+    runOnBasicBlockAdv(BB, RP.getFreeRegisters(Block, ScalarClass) > 0,
+                       IsNonNegative);
+    runOnMultiInstruction(BB);
+  }
+
+  return PreservedAnalyses::none();
+}
@@ -0,0 +1,88 @@
+#ifndef LLVM_TRANSFORMS_SPARSECONSTPROP_H
+#define LLVM_TRANSFORMS_SPARSECONSTPROP_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include <llvm/IR/Constants.h>
+#include <vector>
+
+namespace llvm {
+
+// Reticolo della constant propagation: top (valore non ancora noto),
+// costante, bottom (non costante)
+class ConstLattice {
+public:
+  enum State { Top, Const, Bottom };
+
+  ConstLattice() = default;
+  static ConstLattice getConstant(Constant *C) { return ConstLattice(Const, C); }
+  static ConstLattice getBottom() { return ConstLattice(Bottom, nullptr); }
+
+  bool isTop() const { return Kind == Top; }
+  bool isConstant() const { return Kind == Const; }
+  bool isBottom() const { return Kind == Bottom; }
+  Constant *getConstant() const { return C; }
+
+  // meet: top ^ x = x, bottom ^ x = bottom, c ^ d = (c == d) ? c : bottom
+  // restituisce true se il valore è cambiato
+  bool meet(const ConstLattice &Other);
+
+  bool operator==(const ConstLattice &Other) const {
+    return Kind == Other.Kind && C == Other.C;
+  }
+  bool operator!=(const ConstLattice &Other) const { return !(*this == Other); }
+
+private:
+  ConstLattice(State Kind, Constant *C) : Kind(Kind), C(C) {}
+
+  State Kind = Top;
+  Constant *C = nullptr;
+};
+
+// Sparse Conditional Constant Propagation (Wegman-Zadeck): i valori del
+// reticolo si propagano lungo le catene def-use e solo lungo gli archi del
+// CFG eseguibili
+class SparseConstSolver {
+public:
+  explicit SparseConstSolver(Function &F) : F(F) {}
+
+  // valore noto di un argomento (default bottom)
+  void setArgument(Argument *A, Constant *C);
+
+  void solve();
+
+  ConstLattice getValue(Value *V) const;
+  bool isExecutable(const BasicBlock *BB) const { return ExecBlocks.count(BB); }
+  bool isEdgeExecutable(const BasicBlock *From, const BasicBlock *To) const {
+    return ExecEdges.count({From, To});
+  }
+
+  // sostituisce i valori costanti, semplifica i branch e cancella i blocchi
+  // non eseguibili
+  bool rewrite();
+
+private:
+  void visit(Instruction &I);
+  void visitPHI(PHINode &PN);
+  void visitTerminator(Instruction &I);
+  void update(Instruction &I, const ConstLattice &V);
+  void markEdge(BasicBlock *From, BasicBlock *To);
+  bool resolveUndefBranches();
+
+  Function &F;
+  DenseMap<Value *, ConstLattice> Values;
+  DenseSet<const BasicBlock *> ExecBlocks;
+  DenseSet<std::pair<const BasicBlock *, const BasicBlock *>> ExecEdges;
+  std::vector<BasicBlock *> BlockWorklist;
+  std::vector<Instruction *> InstWorklist;
+};
+
+class SparseConstProp : public PassInfoMixin<SparseConstProp> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_SPARSECONSTPROP_H
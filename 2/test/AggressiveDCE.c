@@ -0,0 +1,24 @@
+#include <stdio.h>
+
+// Il calcolo in t e il loop che accumula s non contribuiscono al risultato:
+// vengono rimossi insieme ai branch che li proteggono
+int dead(int a, int n) {
+  int t = a * 9;
+  if (a > 0)
+    t = t << 3;
+  else
+    t = t - 1;
+
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += i;
+
+  return a;
+}
+
+// La printf è viva, quindi anche il branch che la protegge
+int live(int a) {
+  if (a > 0)
+    printf("%d\n", a);
+  return a + 1;
+}
@@ -0,0 +1,9 @@
+int hoisting(int a, int b, int c) {
+    int x;
+
+    if (c > 0)
+        x = (a + b) * 2;
+    else
+        x = (a + b) * 2 - c;
+    return x;
+}
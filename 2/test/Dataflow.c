@@ -0,0 +1,17 @@
+int dataflow(int a, int b, int c) {
+    int k = 2;
+    int x, y;
+
+    if (c > 0) {
+        x = b - a;
+        do {
+            y = a - b;
+            c -= 1;
+        } while (c > 0);
+    } else {
+        x = b - a;
+        y = 4;
+        k = 3;
+    }
+    return x + y + k;
+}
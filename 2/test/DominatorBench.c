@@ -0,0 +1,31 @@
+// Molti diamanti in sequenza: CFG grande per confrontare i tempi di
+// costruzione dei dominatori
+#define STEP(i) if (x & (1 << ((i) % 16))) x += i; else x -= i;
+#define STEP10(i) STEP(i) STEP(i + 1) STEP(i + 2) STEP(i + 3) STEP(i + 4) \
+  STEP(i + 5) STEP(i + 6) STEP(i + 7) STEP(i + 8) STEP(i + 9)
+#define STEP100(i) STEP10(i) STEP10(i + 10) STEP10(i + 20) STEP10(i + 30) \
+  STEP10(i + 40) STEP10(i + 50) STEP10(i + 60) STEP10(i + 70) \
+  STEP10(i + 80) STEP10(i + 90)
+
+int diamonds(int x) {
+  STEP100(0)
+  STEP100(100)
+  STEP100(200)
+  STEP100(300)
+  STEP100(400)
+  return x;
+}
+
+int loops(int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    if (i % 3 == 0)
+      continue;
+    for (int j = 0; j < i; j++) {
+      if (j == 7)
+        break;
+      s += j;
+    }
+  }
+  return s;
+}
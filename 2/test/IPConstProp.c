@@ -0,0 +1,17 @@
+// scale riceve sempre k = 4: l'argomento diventa costante. foo è chiamata
+// con (0, 4) due volte e con (0, 12) una volta: due specializzazioni
+static int scale(int x, int k) {
+  return x * k / k;
+}
+
+int foo(int c, int z) {
+  int s = 0;
+  for (int i = z; i < 10; i++)
+    s += c + 3;
+  return s;
+}
+
+int main() {
+  int k = 2 + 2;
+  return scale(9, k) + scale(7, 4) + foo(0, 4) + foo(0, 12) + foo(0, 4);
+}
@@ -0,0 +1,18 @@
+int pre(int a, int b, int c) {
+    int x = 0;
+
+    if (c > 0)
+        x = (a + b) * 3;
+    return x + (a + b) * 3;
+}
+
+int pre_loop(int a, int b, int n) {
+    int s = 0;
+    int i = 0;
+
+    do {
+        s += a * b;
+        i++;
+    } while (i < n);
+    return s;
+}
@@ -0,0 +1,16 @@
+// L'indice del loop è non negativo: le divisioni diventano shift e udiv, la
+// sext per l'indirizzo diventa zext
+int ranges(int *v, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    int k = 4;
+    s += v[i] / k + i / (k - 1);
+  }
+  return s;
+}
+
+// Operandi di 16 bit: la divisione a 64 bit può essere fatta su i16
+unsigned long narrow(unsigned a, unsigned char b) {
+  unsigned long x = a & 0xffff;
+  return b ? x / b : 0;
+}
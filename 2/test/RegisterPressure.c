@@ -0,0 +1,20 @@
+// Molti invarianti vivi per tutto il loop: con pochi registri non conviene
+// spostarli tutti nel preheader
+int pressure(int a, int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    s += (a + 1) * (a + 2) + (a + 3) * (a + 4) + (a + 5) * (a + 6);
+    s += (a + 7) * (a + 8) + (a + 9) * (a + 10) + (a + 11) * (a + 12);
+    s += (a + 13) * (a + 14) + (a + 15) * (a + 16) + (a + 17) * (a + 18);
+    s ^= i;
+  }
+  return s;
+}
+
+// Moltiplicazioni per 2^k+1 e 2^k-1: shift+add/sub solo con un registro
+// libero per il temporaneo
+int mul(int a, int b) {
+  int x = a * 9;
+  int y = b * 15;
+  return x + y;
+}
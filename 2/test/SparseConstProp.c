@@ -0,0 +1,13 @@
+int sparse(int x) {
+    int k = 4;
+    int m = 0;
+
+    for (int i = 0; i < 10; i++) {
+        if (k == 4)
+            k = k + 0;
+        else
+            k = k + 1;
+        m = x * k;
+    }
+    return m;
+}
@@ -0,0 +1,118 @@
+#include "llvm/Transforms/Utils/DeadLoopElim.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+
+using namespace llvm;
+
+// costo massimo del calcolo di un valore d'uscita, come in IndVarSimplify:
+// oltre questo limite conviene lasciare il valore al loop
+static const unsigned ExpansionBudget = 4 * TargetTransformInfo::TCC_Basic;
+
+// Le PHI LCSSA delle uscite diventano il valore del loop all'ultima
+// iterazione, calcolato con SCEVExpander nel blocco di uscita. Serve un numero
+// di iterazioni calcolabile e un valore d'uscita uguale per tutti gli archi
+static bool rewriteExitValues(Loop &L, LoopStandardAnalysisResults &LAR) {
+  ScalarEvolution &SE = LAR.SE;
+  if (isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(&L)))
+    return false;
+
+  SmallVector<BasicBlock *, 4> Exits;
+  L.getUniqueExitBlocks(Exits);
+  SCEVExpander Expander(SE, L.getHeader()->getModule()->getDataLayout(),
+                        "exitval");
+  bool Changed = false;
+  for (BasicBlock *Exit : Exits) {
+    Instruction *InsertPt = &*Exit->getFirstInsertionPt();
+    for (PHINode &PN : make_early_inc_range(Exit->phis())) {
+      if (!SE.isSCEVable(PN.getType()) ||
+          all_of(PN.incoming_values(),
+                 [&](Value *V) { return L.isLoopInvariant(V); }))
+        continue;
+
+      const SCEV *ExitValue = SE.getSCEVAtScope(PN.getIncomingValue(0),
+                                                L.getParentLoop());
+      bool Same = all_of(PN.incoming_values(), [&](Value *V) {
+        return SE.getSCEVAtScope(V, L.getParentLoop()) == ExitValue;
+      });
+      if (!Same || isa<SCEVCouldNotCompute>(ExitValue) ||
+          !SE.isLoopInvariant(ExitValue, &L))
+        continue;
+
+      if (!Expander.isSafeToExpandAt(ExitValue, InsertPt) ||
+          Expander.isHighCostExpansion(ExitValue, &L, ExpansionBudget,
+                                       &LAR.TTI, InsertPt)) {
+        outs() << "[DeadLoopElim]: " << PN << " - valore d'uscita troppo costoso\n";
+        continue;
+      }
+
+      Value *V = Expander.expandCodeFor(ExitValue, PN.getType(), InsertPt);
+      if (V == &PN)
+        continue;
+      outs() << "[DeadLoopElim]: " << PN << " -> " << *ExitValue << "\n";
+      PN.replaceAllUsesWith(V);
+      PN.eraseFromParent();
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+// il loop si può rimuovere se termina (con tutti i sottoloop), non ha effetti
+// collaterali e dopo di esso servono solo valori calcolati prima di entrarci
+static bool isLoopDead(Loop &L, ScalarEvolution &SE) {
+  BasicBlock *Exit = L.getUniqueExitBlock();
+  if (!Exit)
+    return false;
+
+  for (Loop *Sub : L.getLoopsInPreorder())
+    if (!isMustProgress(Sub) &&
+        isa<SCEVCouldNotCompute>(SE.getSymbolicMaxBackedgeTakenCount(Sub))) {
+      outs() << "[DeadLoopElim]: loop " << Sub->getName()
+             << " - numero di iterazioni non calcolabile\n";
+      return false;
+    }
+
+  for (BasicBlock *BB : L.blocks())
+    for (Instruction &I : *BB)
+      if (I.mayHaveSideEffects()) {
+        outs() << "[DeadLoopElim]: " << I << " - effetti collaterali\n";
+        return false;
+      }
+
+  for (PHINode &PN : Exit->phis()) {
+    Value *V = PN.getIncomingValue(0);
+    if (!L.isLoopInvariant(V) ||
+        any_of(PN.incoming_values(), [&](Value *In) { return In != V; })) {
+      outs() << "[DeadLoopElim]: " << PN << " - valore calcolato nel loop\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+PreservedAnalyses DeadLoopElim::run(Loop &L, LoopAnalysisManager &LAM,
+                                    LoopStandardAnalysisResults &LAR,
+                                    LPMUpdater &LU) {
+  if (!L.getLoopPreheader() || !L.hasDedicatedExits())
+    return PreservedAnalyses::all();
+
+  auto PA = getLoopPassPreservedAnalyses();
+  if (LAR.MSSA)
+    PA.preserve<MemorySSAAnalysis>();
+
+  bool Changed = rewriteExitValues(L, LAR);
+  if (!isLoopDead(L, LAR.SE))
+    return Changed ? PA : PreservedAnalyses::all();
+
+  // il preheader salta direttamente all'uscita; DominatorTree, LoopInfo,
+  // ScalarEvolution e MemorySSA vengono aggiornati da deleteDeadLoop
+  std::string Name = L.getName().str();
+  outs() << "[DeadLoopElim]: loop " << Name << " eliminato\n";
+  deleteDeadLoop(&L, &LAR.DT, &LAR.SE, &LAR.LI, LAR.MSSA);
+  LU.markLoopAsDeleted(L, Name);
+  return PA;
+}
@@ -0,0 +1,22 @@
+#ifndef LLVM_TRANSFORMS_DEADLOOPELIM_H
+#define LLVM_TRANSFORMS_DEADLOOPELIM_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/Transforms/Scalar/LoopPassManager.h"
+
+namespace llvm {
+
+// Eliminazione dei loop morti: i valori che escono dal loop attraverso le PHI
+// LCSSA vengono sostituiti dalla loro forma chiusa secondo ScalarEvolution
+// (ad esempio 4 * n per un accumulatore incrementato di 4 a ogni giro),
+// calcolata nell'uscita. Se il loop non ha più effetti collaterali, né
+// valori usati dopo di esso, e termina sicuramente, viene rimosso
+class DeadLoopElim : public PassInfoMixin<DeadLoopElim> {
+public:
+  PreservedAnalyses run(Loop &L, LoopAnalysisManager &LAM,
+                        LoopStandardAnalysisResults &LAR, LPMUpdater &LU);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_DEADLOOPELIM_H
@@ -0,0 +1,15 @@
+int a[40 * 37];
+
+int sum(int n, int m, int stride, int lo) {
+  int s = 0;
+  for (int i = lo; i < n; i++)
+    for (int j = 0; j < m; j += 2)
+      s += a[i * stride + j] + i * 16 + j * stride;
+  return s;
+}
+
+int main() {
+  for (int k = 0; k < 40 * 37; k++)
+    a[k] = k;
+  return sum(40, 37, 37, 3);
+}
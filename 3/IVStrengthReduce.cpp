@@ -0,0 +1,167 @@
+#include "llvm/Transforms/Utils/IVStrengthReduce.h"
+#include "llvm/Transforms/Utils/LocalOpts.h"
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+#include <optional>
+
+using namespace llvm;
+
+// Le moltiplicazioni per costante create dall'expander diventano shift e
+// add/sub con runOnBasicBlockAdv. Le istruzioni passano per un blocco
+// temporaneo, così LocalOpts non tocca il resto del preheader: quelle
+// sostituite vengono cancellate e le altre tornano in fondo al preheader,
+// nello stesso ordine
+static void lowerExpandedCode(ArrayRef<WeakVH> Expanded, BasicBlock &Preheader,
+                              bool SpareRegister) {
+  Function &F = *Preheader.getParent();
+  BasicBlock *Tmp = BasicBlock::Create(F.getContext(), "ivsr.tmp", &F);
+  auto *Term = new UnreachableInst(F.getContext(), Tmp);
+  for (const WeakVH &V : Expanded)
+    if (auto *I = dyn_cast_or_null<Instruction>(V))
+      I->moveBefore(Term);
+
+  runOnBasicBlockAdv(*Tmp, SpareRegister);
+  // dal basso verso l'alto, così cadono anche gli operandi rimasti senza usi
+  for (Instruction &I : make_early_inc_range(reverse(*Tmp)))
+    if (&I != Term && isInstructionTriviallyDead(&I))
+      I.eraseFromParent();
+
+  while (&Tmp->front() != Term)
+    Tmp->front().moveBefore(Preheader.getTerminator());
+  Tmp->eraseFromParent();
+}
+
+// moltiplicazione il cui valore a ogni iterazione di L è {Start,+,Step}, con
+// Start e Step invarianti; anche nei sottoloop, dove il valore non cambia.
+// Una moltiplicazione senza usi (ad esempio già sostituita da LocalOpts)
+// non merita un accumulatore
+static const SCEVAddRecExpr *getAffineRec(Instruction &I, Loop &L,
+                                          ScalarEvolution &SE) {
+  if (I.getOpcode() != Instruction::Mul || !I.getType()->isIntegerTy() ||
+      I.use_empty())
+    return nullptr;
+  auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(&I));
+  if (!AR || AR->getLoop() != &L || !AR->isAffine())
+    return nullptr;
+  return AR;
+}
+
+PreservedAnalyses IVStrengthReduce::run(Loop &L, LoopAnalysisManager &LAM,
+                                        LoopStandardAnalysisResults &LAR,
+                                        LPMUpdater &LU) {
+  BasicBlock *Preheader = L.getLoopPreheader();
+  BasicBlock *Latch = L.getLoopLatch();
+  if (!Preheader || !Latch)
+    return PreservedAnalyses::all();
+
+  ScalarEvolution &SE = LAR.SE;
+  SmallVector<std::pair<Instruction *, const SCEVAddRecExpr *>, 8> Candidates;
+  for (BasicBlock *BB : L.blocks())
+    for (Instruction &I : *BB)
+      if (const SCEVAddRecExpr *AR = getAffineRec(I, L, SE))
+        Candidates.push_back({&I, AR});
+  if (Candidates.empty())
+    return PreservedAnalyses::all();
+
+  // le variabili di induzione già presenti valgono come accumulatori
+  DenseMap<const SCEV *, Value *> Accumulators;
+  for (PHINode &PN : L.getHeader()->phis())
+    if (SE.isSCEVable(PN.getType()))
+      Accumulators.try_emplace(SE.getSCEV(&PN), &PN);
+
+  // ogni nuovo accumulatore resta vivo per tutto il loop: se ne creano solo
+  // finché la sua classe ha registri liberi. La liveness dell'intera
+  // funzione si calcola solo se serve un accumulatore nuovo
+  Function &F = *Preheader->getParent();
+  std::optional<RegisterPressure> RP;
+  DenseMap<unsigned, unsigned> FreeRegisters;
+
+  SCEVExpander Expander(SE, F.getParent()->getDataLayout(), "ivsr");
+  Instruction *InsertPt = Preheader->getTerminator();
+  SmallVector<WeakTrackingVH, 8> Replaced;
+  for (auto &[I, AR] : Candidates) {
+    Value *Acc = Accumulators.lookup(AR);
+    if (!Acc) {
+      const SCEV *Start = AR->getStart();
+      const SCEV *Step = AR->getStepRecurrence(SE);
+      if (!Expander.isSafeToExpandAt(Start, InsertPt) ||
+          !Expander.isSafeToExpandAt(Step, InsertPt)) {
+        outs() << "[IVStrengthReduce]: " << *I
+               << " - Start o Step non calcolabili nel preheader\n";
+        continue;
+      }
+
+      if (!RP)
+        RP.emplace(F, LAR.TTI);
+      unsigned ClassID = RP->getRegisterClass(I->getType());
+      auto Free = FreeRegisters.try_emplace(
+          ClassID, RP->getFreeRegisters(L.getBlocks(), ClassID));
+      if (Free.first->second == 0) {
+        outs() << "[IVStrengthReduce]: " << *I
+               << " - Non ridotta: registri insufficienti nel loop\n";
+        continue;
+      }
+      --Free.first->second;
+
+      Value *StartV = Expander.expandCodeFor(Start, I->getType(), InsertPt);
+      Value *StepV = Expander.expandCodeFor(Step, I->getType(), InsertPt);
+      PHINode *PN = PHINode::Create(I->getType(), 2, I->getName() + ".iv",
+                                    &L.getHeader()->front());
+      // senza flag nsw/nuw: l'accumulatore ripete l'aritmetica modulo 2^n
+      // della moltiplicazione, anche quando questa va in overflow
+      Value *Next = BinaryOperator::CreateAdd(PN, StepV, I->getName() + ".iv.next",
+                                              Latch->getTerminator());
+      PN->addIncoming(StartV, Preheader);
+      PN->addIncoming(Next, Latch);
+      Accumulators[AR] = Acc = PN;
+    }
+
+    outs() << "[IVStrengthReduce]: " << *I << " -> " << *Acc << "\n";
+    I->replaceAllUsesWith(Acc);
+    Replaced.push_back(I);
+  }
+
+  // istruzioni create dall'expander nel preheader, nell'ordine del blocco.
+  // L'expander tiene degli AssertingVH su di esse: va svuotato prima che
+  // vengano sostituite o cancellate
+  SmallPtrSet<Instruction *, 16> Inserted;
+  for (Instruction *I : Expander.getAllInsertedInstructions())
+    if (I->getParent() == Preheader)
+      Inserted.insert(I);
+  SmallVector<WeakVH, 16> Expanded;
+  for (Instruction &I : *Preheader)
+    if (Inserted.count(&I))
+      Expanded.push_back(&I);
+  Expander.clear();
+
+  if (Replaced.empty())
+    return PreservedAnalyses::all();
+
+  std::optional<MemorySSAUpdater> MSSAU;
+  if (LAR.MSSA)
+    MSSAU.emplace(LAR.MSSA);
+  RecursivelyDeleteTriviallyDeadInstructions(Replaced, &LAR.TLI,
+                                             MSSAU ? &*MSSAU : nullptr);
+
+  // le moltiplicazioni per costante di Start e Step diventano shift e
+  // add/sub, con il temporaneo solo se il preheader ha un registro libero
+  if (!Expanded.empty()) {
+    unsigned ScalarClass =
+        RP->getRegisterClass(Type::getInt32Ty(F.getContext()));
+    lowerExpandedCode(Expanded, *Preheader,
+                      RP->getFreeRegisters(Preheader, ScalarClass) > 0);
+  }
+
+  auto PA = getLoopPassPreservedAnalyses();
+  if (LAR.MSSA)
+    PA.preserve<MemorySSAAnalysis>();
+  return PA;
+}
@@ -0,0 +1,23 @@
+#ifndef LLVM_TRANSFORMS_IVSTRENGTHREDUCE_H
+#define LLVM_TRANSFORMS_IVSTRENGTHREDUCE_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/Transforms/Scalar/LoopPassManager.h"
+
+namespace llvm {
+
+// Strength reduction sulle variabili di induzione: le moltiplicazioni del
+// loop che ScalarEvolution riconosce come funzioni affini delle iterazioni
+// ({Start,+,Step}, come i * stride o base + i * 16) diventano un accumulatore
+// nell'header incrementato di Step a ogni giro. Start e Step vengono
+// calcolati nel preheader, dove le moltiplicazioni per costante sono
+// abbassate a shift e add/sub da runOnBasicBlockAdv
+class IVStrengthReduce : public PassInfoMixin<IVStrengthReduce> {
+public:
+  PreservedAnalyses run(Loop &L, LoopAnalysisManager &LAM,
+                        LoopStandardAnalysisResults &LAR, LPMUpdater &LU);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_IVSTRENGTHREDUCE_H
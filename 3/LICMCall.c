@@ -0,0 +1,24 @@
+#include <string.h>
+
+static int square(int x) { return x * x; }
+
+int count(const char *s, int a) {
+  int acc = 0;
+  for (size_t i = 0; i < strlen(s); i++)
+    acc += s[i] + square(a);
+  return acc;
+}
+
+int copy(char *d, const char *s) {
+  size_t len = 0;
+  for (size_t i = 0; i < 11; i++) {
+    len = strlen(d);
+    d[i] = s[i];
+  }
+  return len;
+}
+
+int main() {
+  char buf[12] = {0};
+  return count("hello world", 3) + copy(buf, "hello world");
+}
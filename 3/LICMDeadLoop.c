@@ -0,0 +1,23 @@
+#include <stdio.h>
+
+int last(int n, int c) {
+  int i, s = 0, k = 0;
+  for (i = 0; i < n; i++) {
+    k = c + 3;
+    s += 4;
+  }
+  return s + i + k;
+}
+
+int tri(int n) {
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < 8; j++)
+      s++;
+  return s;
+}
+
+int main() {
+  printf("%d %d\n", last(10, 5), tri(7));
+  return 0;
+}
@@ -0,0 +1,18 @@
+int guarded(int n, int a, int b) {
+  int s = 0;
+  if (n > 0)
+    for (int i = 0; i < n; i++)
+      s += a / b;
+  return s;
+}
+
+int unguarded(int n, int a, int b) {
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += a / b;
+  return s;
+}
+
+int main() {
+  return guarded(10, 100, 7) + unguarded(0, 100, 0);
+}
@@ -0,0 +1,14 @@
+unsigned buckets[1024];
+
+void hash(const unsigned *keys, int n, unsigned size) {
+  for (int i = 0; i < n; i++)
+    buckets[keys[i] % size]++;
+}
+
+int main() {
+  unsigned keys[64];
+  for (int i = 0; i < 64; i++)
+    keys[i] = i * 2654435761u;
+  hash(keys, 64, 37);
+  return buckets[0];
+}
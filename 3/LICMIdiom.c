@@ -0,0 +1,40 @@
+#include <stdio.h>
+
+int a[64], d[64];
+
+void clear(int n) {
+  for (int i = 0; i < n; i++)
+    d[i] = 0;
+}
+
+void copy(int n) {
+  for (int i = 0; i < n; i++)
+    d[i] = a[i];
+}
+
+int pop(unsigned x) {
+  int cnt = 0;
+  while (x) {
+    x &= x - 1;
+    cnt++;
+  }
+  return cnt;
+}
+
+int bits(unsigned x) {
+  int cnt = 0;
+  while (x) {
+    x >>= 1;
+    cnt++;
+  }
+  return cnt;
+}
+
+int main() {
+  for (int k = 0; k < 64; k++)
+    a[k] = 3 * k;
+  clear(10);
+  copy(20);
+  printf("%d %d %d\n", d[19], pop(1234567), bits(4097));
+  return 0;
+}
@@ -0,0 +1,15 @@
+int x[16];
+int scale = 5;
+
+void accumulate(int *restrict sum, int n) {
+  for (int i = 0; i < n; i++)
+    *sum += x[i] * scale;
+}
+
+int main() {
+  int sum = 0;
+  for (int k = 0; k < 16; k++)
+    x[k] = k;
+  accumulate(&sum, 16);
+  return sum;
+}
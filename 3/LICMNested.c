@@ -0,0 +1,18 @@
+int a[64];
+
+int stencil(int n, int m, int s, int t) {
+  int acc = 0;
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < m; j++) {
+      int c = s * t + 7;
+      int d = c + i;
+      acc += a[i + j] * c + d;
+    }
+  return acc;
+}
+
+int main() {
+  for (int k = 0; k < 64; k++)
+    a[k] = 3 * k;
+  return stencil(5, 8, 3, 4);
+}
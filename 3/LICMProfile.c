@@ -0,0 +1,14 @@
+int scale(int n, int a, int b) {
+  int s = 0;
+  for (int i = 0; i < n; i++)
+    s += a * b;
+  return s;
+}
+
+int main(int argc, char **argv) {
+  int s = 0;
+  // quasi sempre n = 0: il corpo del loop non viene eseguito
+  for (int k = 0; k < 1000; k++)
+    s += scale(k % 100 == 0 ? argc : 0, k, 3);
+  return s;
+}
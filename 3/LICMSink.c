@@ -0,0 +1,13 @@
+int last(int n, int a) {
+  int e;
+  int i = 0;
+  do {
+    e = i * i / 3 + a;
+    i++;
+  } while (i < n);
+  return e;
+}
+
+int main() {
+  return last(20, 5);
+}
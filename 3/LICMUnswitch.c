@@ -0,0 +1,17 @@
+int data[32];
+
+int process(int n, int verbose, int a) {
+  int s = 0;
+  for (int i = 0; i < n; i++) {
+    if (verbose)
+      data[i] = i * a;
+    else
+      s += data[i] + 3;
+    s += data[i];
+  }
+  return s;
+}
+
+int main() {
+  return process(20, 1, 3) + process(20, 0, 3);
+}
@@ -0,0 +1,276 @@
+#include "llvm/Transforms/Utils/LoopIdioms.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PatternMatch.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+#include <optional>
+
+using namespace llvm;
+using namespace PatternMatch;
+
+// indirizzo {Start,+,Size}<L>: a ogni iterazione l'elemento successivo,
+// senza spazi tra un elemento e l'altro
+static const SCEVAddRecExpr *getConsecutiveRec(Value *Ptr, Type *Ty, Loop &L,
+                                               ScalarEvolution &SE) {
+  const DataLayout &DL = L.getHeader()->getModule()->getDataLayout();
+  uint64_t Size = DL.getTypeStoreSize(Ty);
+  if (Size != DL.getTypeAllocSize(Ty))
+    return nullptr;
+
+  auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(Ptr));
+  if (!AR || AR->getLoop() != &L || !AR->isAffine())
+    return nullptr;
+  auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+  if (!Step || Step->getAPInt() != Size)
+    return nullptr;
+  return AR;
+}
+
+// Store di un valore invariante (memset) o copia da un'altra area (memcpy).
+// La store deve essere l'unico accesso alla memoria del loop, oltre alla load
+// che legge il valore da copiare, ed essere eseguita a ogni iterazione: il
+// numero di elementi è il numero di giri, secondo ScalarEvolution
+static bool recognizeMemIdiom(Loop &L, LoopStandardAnalysisResults &LAR,
+                              MemorySSAUpdater *MSSAU) {
+  ScalarEvolution &SE = LAR.SE;
+  const SCEV *BECount = SE.getBackedgeTakenCount(&L);
+  if (isa<SCEVCouldNotCompute>(BECount))
+    return false;
+
+  StoreInst *SI = nullptr;
+  SmallVector<LoadInst *, 1> Loads;
+  for (BasicBlock *BB : L.blocks())
+    for (Instruction &I : *BB) {
+      if (auto *Store = dyn_cast<StoreInst>(&I)) {
+        if (SI)
+          return false;
+        SI = Store;
+      } else if (auto *LoadI = dyn_cast<LoadInst>(&I)) {
+        Loads.push_back(LoadI);
+      } else if (I.mayReadOrWriteMemory() || I.mayHaveSideEffects()) {
+        return false;
+      }
+    }
+  if (!SI || !SI->isSimple() || LAR.LI.getLoopFor(SI->getParent()) != &L)
+    return false;
+
+  // se il blocco domina anche le uscite la store viene eseguita pure
+  // nell'ultimo giro; altrimenti si esce dall'header prima di arrivarci
+  BasicBlock *Block = SI->getParent();
+  BasicBlock *Latch = L.getLoopLatch();
+  if (!Latch || !LAR.DT.dominates(Block, Latch))
+    return false;
+  SmallVector<BasicBlock *, 4> Exits;
+  L.getUniqueExitBlocks(Exits);
+  bool LastIteration = all_of(
+      Exits, [&](BasicBlock *Exit) { return LAR.DT.dominates(Block, Exit); });
+  if (!LastIteration && (L.getExitingBlock() != L.getHeader() ||
+                         Block == L.getHeader()))
+    return false;
+
+  Value *StoredVal = SI->getValueOperand();
+  const SCEVAddRecExpr *Dst =
+      getConsecutiveRec(SI->getPointerOperand(), StoredVal->getType(), L, SE);
+  if (!Dst)
+    return false;
+
+  const DataLayout &DL = Block->getModule()->getDataLayout();
+  Value *SplatValue = nullptr;
+  LoadInst *Load = nullptr;
+  const SCEVAddRecExpr *Src = nullptr;
+  if (L.isLoopInvariant(StoredVal)) {
+    if (Loads.empty())
+      SplatValue = isBytewiseValue(StoredVal, DL);
+  } else if ((Load = dyn_cast<LoadInst>(StoredVal)) && Load->isSimple() &&
+             Load->hasOneUse() && Loads.size() == 1) {
+    // con aree sovrapposte il loop propaga i valori appena scritti,
+    // memcpy no
+    Src = getConsecutiveRec(Load->getPointerOperand(), Load->getType(), L, SE);
+    if (Src && !LAR.AA.isNoAlias(
+                   MemoryLocation::getBeforeOrAfter(Load->getPointerOperand()),
+                   MemoryLocation::getBeforeOrAfter(SI->getPointerOperand())))
+      Src = nullptr;
+  }
+  if (!SplatValue && !Src)
+    return false;
+
+  BasicBlock *Preheader = L.getLoopPreheader();
+  Instruction *InsertPt = Preheader->getTerminator();
+  Type *IntPtrTy = DL.getIntPtrType(SI->getPointerOperandType());
+  const SCEV *TripCount = SE.getTruncateOrZeroExtend(BECount, IntPtrTy);
+  if (LastIteration)
+    TripCount = SE.getAddExpr(TripCount, SE.getOne(IntPtrTy));
+  const SCEV *NumBytes = SE.getMulExpr(
+      TripCount,
+      SE.getConstant(IntPtrTy, DL.getTypeStoreSize(StoredVal->getType())));
+
+  SCEVExpander Expander(SE, DL, "idiom");
+  if (!Expander.isSafeToExpandAt(Dst->getStart(), InsertPt) ||
+      !Expander.isSafeToExpandAt(NumBytes, InsertPt) ||
+      (Src && !Expander.isSafeToExpandAt(Src->getStart(), InsertPt)))
+    return false;
+
+  IRBuilder<> B(InsertPt);
+  Value *DstPtr = Expander.expandCodeFor(Dst->getStart(),
+                                         SI->getPointerOperandType(), InsertPt);
+  Value *Size = Expander.expandCodeFor(NumBytes, IntPtrTy, InsertPt);
+  CallInst *Call;
+  if (SplatValue) {
+    Call = B.CreateMemSet(DstPtr, SplatValue, Size, SI->getAlign());
+  } else {
+    Value *SrcPtr = Expander.expandCodeFor(
+        Src->getStart(), Load->getPointerOperandType(), InsertPt);
+    Call = B.CreateMemCpy(DstPtr, SI->getAlign(), SrcPtr, Load->getAlign(),
+                          Size);
+  }
+  Call->setDebugLoc(SI->getDebugLoc());
+  outs() << "[LoopIdioms]: " << *SI << " -> " << *Call << "\n";
+
+  if (MSSAU) {
+    MemoryAccess *Access = MSSAU->createMemoryAccessInBB(
+        Call, nullptr, Preheader, MemorySSA::BeforeTerminator);
+    MSSAU->insertDef(cast<MemoryDef>(Access), true);
+  }
+
+  SmallVector<WeakTrackingVH, 4> Dead;
+  Dead.push_back(SI->getPointerOperand());
+  if (Load)
+    Dead.push_back(Load->getPointerOperand());
+  if (MSSAU)
+    MSSAU->removeMemoryAccess(SI);
+  SI->eraseFromParent();
+  if (Load) {
+    if (MSSAU)
+      MSSAU->removeMemoryAccess(Load);
+    Load->eraseFromParent();
+  }
+  RecursivelyDeleteTriviallyDeadInstructionsPermissive(Dead, &LAR.TLI, MSSAU);
+  return true;
+}
+
+// while (x) { x &= x - 1; cnt++; } fa ctpop(x) giri, while (x) { x >>= 1;
+// cnt++; } ne fa bitwidth - ctlz(x). All'uscita x vale 0 e ogni contatore
+// vale il valore iniziale più il numero di giri, calcolato nel preheader; il
+// test di uscita diventa un confronto sul contatore, così ScalarEvolution
+// conosce il numero di iterazioni e il loop può essere eliminato
+static bool recognizeBitCount(Loop &L, LoopStandardAnalysisResults &LAR) {
+  BasicBlock *Header = L.getHeader();
+  BasicBlock *Preheader = L.getLoopPreheader();
+  BasicBlock *Latch = L.getLoopLatch();
+  if (!Latch || L.getExitingBlock() != Header)
+    return false;
+
+  auto *BI = dyn_cast<BranchInst>(Header->getTerminator());
+  ICmpInst::Predicate Pred;
+  Value *X;
+  if (!BI || !BI->isConditional() ||
+      !match(BI->getCondition(), m_ICmp(Pred, m_Value(X), m_Zero())) ||
+      !X->getType()->isIntegerTy())
+    return false;
+  unsigned ExitIdx = L.contains(BI->getSuccessor(0)) ? 1 : 0;
+  if (!ICmpInst::isEquality(Pred) ||
+      (Pred == ICmpInst::ICMP_EQ) != (ExitIdx == 0))
+    return false;
+
+  auto *XPhi = dyn_cast<PHINode>(X);
+  if (!XPhi || XPhi->getParent() != Header)
+    return false;
+  Value *X0 = XPhi->getIncomingValueForBlock(Preheader);
+  Value *XNext = XPhi->getIncomingValueForBlock(Latch);
+  Intrinsic::ID ID;
+  if (match(XNext, m_c_And(m_Specific(XPhi),
+                           m_CombineOr(m_Add(m_Specific(XPhi), m_AllOnes()),
+                                       m_Sub(m_Specific(XPhi), m_One())))))
+    ID = Intrinsic::ctpop;
+  else if (match(XNext, m_LShr(m_Specific(XPhi), m_One())))
+    ID = Intrinsic::ctlz;
+  else
+    return false;
+
+  // contatori incrementati di 1 a ogni giro, abbastanza larghi da non
+  // tornare al valore iniziale prima dell'uscita
+  unsigned BitWidth = X->getType()->getIntegerBitWidth();
+  SmallVector<PHINode *, 2> Counters;
+  for (PHINode &PN : Header->phis())
+    if (PN.getType()->isIntegerTy() &&
+        PN.getType()->getIntegerBitWidth() > Log2_32(BitWidth) &&
+        match(PN.getIncomingValueForBlock(Latch),
+              m_c_Add(m_Specific(&PN), m_One())))
+      Counters.push_back(&PN);
+  if (Counters.empty())
+    return false;
+
+  IRBuilder<> B(Preheader->getTerminator());
+  Value *Trips;
+  if (ID == Intrinsic::ctpop)
+    Trips = B.CreateUnaryIntrinsic(Intrinsic::ctpop, X0, nullptr, "trips");
+  else
+    Trips = B.CreateSub(
+        ConstantInt::get(X->getType(), BitWidth),
+        B.CreateBinaryIntrinsic(Intrinsic::ctlz, X0, B.getFalse()), "trips");
+  outs() << "[LoopIdioms]: " << *XNext << " -> " << *Trips << "\n";
+
+  BasicBlock *Exit = BI->getSuccessor(ExitIdx);
+  for (PHINode &PN : make_early_inc_range(Exit->phis()))
+    if (PN.getIncomingValueForBlock(Header) == XPhi) {
+      PN.replaceAllUsesWith(Constant::getNullValue(XPhi->getType()));
+      PN.eraseFromParent();
+    }
+
+  for (PHINode *Cnt : Counters) {
+    Value *Final = B.CreateAdd(Cnt->getIncomingValueForBlock(Preheader),
+                               B.CreateZExtOrTrunc(Trips, Cnt->getType()),
+                               Cnt->getName() + ".final");
+    if (Cnt == Counters.front()) {
+      Value *Done = new ICmpInst(BI, ExitIdx == 0 ? ICmpInst::ICMP_EQ
+                                                  : ICmpInst::ICMP_NE,
+                                 Cnt, Final);
+      Value *OldCond = BI->getCondition();
+      BI->setCondition(Done);
+      RecursivelyDeleteTriviallyDeadInstructions(OldCond, &LAR.TLI);
+    }
+    for (PHINode &PN : make_early_inc_range(Exit->phis()))
+      if (PN.getIncomingValueForBlock(Header) == Cnt) {
+        PN.replaceAllUsesWith(Final);
+        PN.eraseFromParent();
+      }
+  }
+
+  LAR.SE.forgetLoop(&L);
+  return true;
+}
+
+PreservedAnalyses LoopIdioms::run(Loop &L, LoopAnalysisManager &LAM,
+                                  LoopStandardAnalysisResults &LAR,
+                                  LPMUpdater &LU) {
+  if (!L.getLoopPreheader() || !L.hasDedicatedExits())
+    return PreservedAnalyses::all();
+
+  // le funzioni che implementano memset e memcpy con un loop diventerebbero
+  // ricorsive
+  StringRef Name = L.getHeader()->getParent()->getName();
+  if (Name == "memset" || Name == "memcpy")
+    return PreservedAnalyses::all();
+
+  std::optional<MemorySSAUpdater> MSSAU;
+  if (LAR.MSSA)
+    MSSAU.emplace(LAR.MSSA);
+
+  bool Changed = recognizeMemIdiom(L, LAR, MSSAU ? &*MSSAU : nullptr);
+  Changed |= recognizeBitCount(L, LAR);
+  if (!Changed)
+    return PreservedAnalyses::all();
+
+  auto PA = getLoopPassPreservedAnalyses();
+  if (LAR.MSSA)
+    PA.preserve<MemorySSAAnalysis>();
+  return PA;
+}
@@ -0,0 +1,23 @@
+#ifndef LLVM_TRANSFORMS_LOOPIDIOMS_H
+#define LLVM_TRANSFORMS_LOOPIDIOMS_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/Transforms/Scalar/LoopPassManager.h"
+
+namespace llvm {
+
+// Riconoscimento di idiomi nei loop: una store di un valore costante o una
+// copia su indirizzi consecutivi (a[i] = 0, d[i] = a[i]) diventano una
+// chiamata a llvm.memset o llvm.memcpy nel preheader; i loop che contano i
+// bit di x (x &= x - 1 oppure x >>= 1 fino a x == 0) ricevono il numero di
+// giri da llvm.ctpop o llvm.ctlz. Il loop rimasto senza effetti viene poi
+// eliminato da deadloopelim
+class LoopIdioms : public PassInfoMixin<LoopIdioms> {
+public:
+  PreservedAnalyses run(Loop &L, LoopAnalysisManager &LAM,
+                        LoopStandardAnalysisResults &LAR, LPMUpdater &LU);
+};
+
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_LOOPIDIOMS_H
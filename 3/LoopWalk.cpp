@@ -1,108 +1,991 @@
 #include "llvm/Transforms/Utils/LoopWalk.h"
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/Loads.h"
+#include "llvm/Analysis/LoopIterator.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
+#include "llvm/Analysis/MustExecute.h"
+#include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/InstrTypes.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Transforms/Utils/SSAUpdater.h"
 #include <cmath>
+#include <map>
+#include <optional>
 
 using namespace llvm;
 
-std::vector<Instruction*> ToMove;
-std::set<Instruction*> Invariants;
+// dimensione massima (in istruzioni) di un loop da duplicare con
+// l'unswitching, divisa per il numero di loop esterni della funzione: ogni
+// duplicazione ne aggiunge uno, così la crescita del codice resta limitata
+static const unsigned UnswitchBudget = 400;
 
-bool isOpInv(Value *operand, Loop &loop) {
+// iterazioni minime perché la divisione su 2N bit nel preheader sia
+// ripagata dalle divisioni risparmiate nel loop
+static const unsigned MinDivisionTrips = 4;
+
+// stato della visita di un singolo loop: istruzioni da spostare nel
+// preheader, nell'ordine in cui sono state trovate (gli operandi prima degli
+// usi), e insieme degli invarianti
+struct LoopState {
+  LoopState(LoopStandardAnalysisResults &LAR, MemorySSAUpdater *MSSAU)
+      : LAR(LAR), MSSAU(MSSAU) {}
+
+  LoopStandardAnalysisResults &LAR;
+  // presente solo se il passo gira con MemorySSA (loop-mssa)
+  MemorySSAUpdater *MSSAU;
+
+  // istruzioni che possono non restituire il controllo (eccezioni, exit)
+  SimpleLoopSafetyInfo SafetyInfo;
+  // il primo giro arriva sicuramente al latch
+  bool RunsOnce = false;
+
+  std::vector<Instruction*> ToMove;
+  std::set<Instruction*> Invariants;
+};
+
+bool isOpInv(Value *operand, Loop &loop, LoopState &state) {
   if (isa<llvm::Constant>(operand) || isa<llvm::Argument>(operand)) {
     return true;
   }
 
   if (llvm::Instruction *inst = dyn_cast<llvm::Instruction>(operand)) {
-    if (!loop.contains(inst->getParent()) || Invariants.count(inst)) {
+    if (!loop.contains(inst->getParent()) || state.Invariants.count(inst)) {
       return true;
     }
   }
   return false;
 }
 
-bool isInstInv(Instruction *I, Loop &loop) {
- 
-  if (!isSafeToSpeculativelyExecute(I)) {
-    outs() << *I << " - Errore! L'istruzione non può essere spostata \n";
+// nessuna istruzione del loop scrive la memoria letta da reader (una load o
+// una chiamata readonly): con MemorySSA basta che l'accesso che la modifica
+// per ultimo sia fuori dal loop, senza si interroga l'alias analysis su
+// tutte le scritture del loop
+bool isMemoryInv(Instruction *reader, Loop &loop, LoopState &state) {
+  auto *load = dyn_cast<LoadInst>(reader);
+  if (load && !load->isUnordered())
     return false;
+
+  if (state.MSSAU) {
+    MemorySSA *MSSA = state.MSSAU->getMemorySSA();
+    MemoryAccess *clobber = MSSA->getWalker()->getClobberingMemoryAccess(reader);
+    return MSSA->isLiveOnEntryDef(clobber) || !loop.contains(clobber->getBlock());
+  }
+
+  for (BasicBlock *block : loop.blocks())
+    for (Instruction &I : *block) {
+      if (!I.mayWriteToMemory())
+        continue;
+      ModRefInfo MRI = load ? state.LAR.AA.getModRefInfo(&I, MemoryLocation::get(load))
+                            : state.LAR.AA.getModRefInfo(&I, cast<CallBase>(reader));
+      if (isModSet(MRI))
+        return false;
+    }
+  return true;
+}
+
+// chiamate che si comportano come un'espressione: non scrivono memoria,
+// terminano sempre e non lanciano eccezioni (readnone, oppure readonly se il
+// loop non scrive la memoria che leggono, come strlen(s))
+bool isPureCall(Instruction *I) {
+  auto *call = dyn_cast<CallInst>(I);
+  return call && !isa<DbgInfoIntrinsic>(call) && !call->isConvergent() &&
+         !call->getType()->isVoidTy() && call->onlyReadsMemory() &&
+         call->hasFnAttr(Attribute::WillReturn) && call->doesNotThrow();
+}
+
+// il loop esegue almeno un'iterazione completa: nessuna uscita prima del
+// latch può essere presa al primo giro, secondo SCEV o secondo le condizioni
+// che proteggono l'ingresso nel loop (es. if (n > 0) prima di un for), e
+// nessuna istruzione o sottoloop può fermare l'esecuzione prima del latch
+bool runsAtLeastOnce(Loop &loop, LoopState &state) {
+  ScalarEvolution &SE = state.LAR.SE;
+  BasicBlock *latch = loop.getLoopLatch();
+  if (!latch || state.SafetyInfo.anyBlockMayThrow())
+    return false;
+
+  for (Loop *subLoop : loop.getLoopsInPreorder())
+    if (subLoop != &loop &&
+        isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(subLoop)))
+      return false;
+
+  SmallVector<BasicBlock*, 4> exiting;
+  loop.getExitingBlocks(exiting);
+  for (BasicBlock *block : exiting) {
+    if (block == latch)
+      continue;
+    // iterazioni complete prima di uscire da questo blocco
+    const SCEV *count = SE.getExitCount(&loop, block);
+    if (isa<SCEVCouldNotCompute>(count))
+      return false;
+    const SCEV *zero = SE.getZero(count->getType());
+    if (!SE.isKnownPredicate(ICmpInst::ICMP_NE, count, zero) &&
+        !SE.isLoopEntryGuardedByCond(&loop, ICmpInst::ICMP_NE, count, zero))
+      return false;
+  }
+  return true;
+}
+
+// l'istruzione viene eseguita ogni volta che si entra nel loop: spostarla nel
+// preheader non aggiunge esecuzioni, anche se può causare un trap
+bool isGuaranteedToExecute(Instruction *I, Loop &loop, LoopState &state) {
+  if (state.SafetyInfo.isGuaranteedToExecute(*I, &state.LAR.DT, &loop))
+    return true;
+  return state.RunsOnce &&
+         state.LAR.DT.dominates(I->getParent(), loop.getLoopLatch());
+}
+
+// frequenza del blocco secondo i profili di esecuzione: 0 se non ci sono
+// profili (BlockFrequencyInfo è disponibile solo con dati PGO) o se il
+// blocco è stato creato dopo l'analisi, in quei casi non si decide in base
+// alla frequenza
+uint64_t getFrequency(BasicBlock *block, LoopState &state) {
+  if (!state.LAR.BFI)
+    return 0;
+  return state.LAR.BFI->getBlockFreq(block).getFrequency();
+}
+
+// il valore calcolato nel preheader deve raggiungere tutti gli usi: vale per
+// gli usi nel loop e per le PHI LCSSA delle uscite, non per eventuali usi in
+// blocchi che il preheader non domina
+bool usesDominated(Instruction *I, BasicBlock *preheader, LoopState &state) {
+  return all_of(I->uses(), [&](Use &U) {
+    return state.LAR.DT.dominates(preheader->getTerminator(), U);
+  });
+}
+
+bool isInstInv(Instruction *I, Loop &loop, LoopState &state,
+               BasicBlock *preheader) {
+ 
+  // le istruzioni senza effetti si possono spostare da qualunque blocco, se
+  // il preheader domina i loro usi; divisioni, load e chiamate pure che non
+  // si possono anticipare liberamente vengono spostate solo se il loop le
+  // esegue comunque
+  if (isSafeToSpeculativelyExecute(I)) {
+    if (!usesDominated(I, preheader, state)) {
+      outs() << *I << " - Errore! Usi non dominati dal preheader\n";
+      return false;
+    }
+  } else {
+    bool movable = (I->isIntDivRem() || isa<LoadInst>(I) || isPureCall(I)) &&
+                   isGuaranteedToExecute(I, loop, state);
+    if (!movable) {
+      outs() << *I << " - Errore! L'istruzione non può essere spostata \n";
+      return false;
+    }
+    outs() << *I << " - Eseguita a ogni ingresso nel loop\n";
+  }
+
+  // una load o una chiamata readonly si può anticipare, ma non oltre le
+  // scritture alla stessa memoria
+  if (I->mayReadFromMemory()) {
+    if (!isMemoryInv(I, loop, state)) {
+      outs() << *I << " - Errore! La memoria letta viene modificata nel loop\n";
+      return false;
+    }
   }
  
   for(auto it = I->op_begin(); it != I->op_end(); ++it) {
-    if (!isOpInv(*it, loop)) 
+    if (!isOpInv(*it, loop, state)) 
       return false;
   }
+
+  // un blocco eseguito raramente (loop che di solito non fanno nemmeno un
+  // giro) non va anticipato in un preheader più frequente
+  uint64_t blockFreq = getFrequency(I->getParent(), state);
+  if (blockFreq && getFrequency(preheader, state) > blockFreq) {
+    outs() << *I << " - Non spostata: il preheader è eseguito più spesso del blocco\n";
+    return false;
+  }
   outs() << "Istruzione removibile: " << *I << "\n";
   
   return true;
 }
 
-void findInstInv(BasicBlock &block, Loop &loop) {
+void findInstInv(BasicBlock &block, Loop &loop, LoopState &state,
+                 BasicBlock *preheader) {
   for(auto &I : block) {
-    if (isInstInv(&I, loop)) {
-        ToMove.push_back(&I);
-        Invariants.insert(&I);
+    if (isInstInv(&I, loop, state, preheader)) {
+        state.ToMove.push_back(&I);
+        state.Invariants.insert(&I);
       }
   } 
 }
 
-bool runOnLoop(Loop &loop, LoopAnalysisManager &LAM, LoopStandardAnalysisResults &LAR, LPMUpdater &LU) {
+// un invariante spostato nel preheader resta vivo per tutto il loop: se i
+// registri liberi della sua classe non bastano si rinuncia agli ultimi
+// trovati, purché nessun altro invariante da spostare li usi. La pressione
+// è quella di tutta la funzione, condivisa dai loop del nido e ricalcolata
+// solo dopo che un loop ha modificato l'IR
+void limitPressure(Loop &loop, const TargetTransformInfo &TTI, LoopState &state,
+                   std::optional<RegisterPressure> &pressure) {
+  if (!pressure)
+    pressure.emplace(*loop.getHeader()->getParent(), TTI);
+  RegisterPressure &RP = *pressure;
+  DenseMap<unsigned, unsigned> Hoisted;
+  for (Instruction *I : state.ToMove)
+    if (loop.contains(I) && !I->getType()->isVoidTy())
+      ++Hoisted[RP.getRegisterClass(I->getType())];
 
-  // controllo e visualizzazione preheader
-  BasicBlock* preheader = loop.getLoopPreheader();
-  preheader->print(outs());
+  for (int Idx = state.ToMove.size() - 1; Idx >= 0; --Idx) {
+    Instruction *I = state.ToMove[Idx];
+    if (!loop.contains(I) || I->getType()->isVoidTy())
+      continue;
+    unsigned ClassID = RP.getRegisterClass(I->getType());
+    if (Hoisted[ClassID] <= RP.getFreeRegisters(loop.getBlocks(), ClassID))
+      continue;
+
+    bool UsedByInvariant = any_of(I->users(), [&](User *U) {
+      auto *UI = dyn_cast<Instruction>(U);
+      return UI && loop.contains(UI) && state.Invariants.count(UI);
+    });
+    if (UsedByInvariant)
+      continue;
+
+    outs() << *I << " - Non spostata: registri insufficienti nel loop\n";
+    state.Invariants.erase(I);
+    state.ToMove.erase(state.ToMove.begin() + Idx);
+    --Hoisted[ClassID];
+  }
+}
+
+// Riscrive gli accessi promossi con SSAUpdater: le load diventano i valori
+// disponibili (la load nel preheader o l'ultimo valore scritto), le store
+// vengono rimosse e l'ultimo valore viene scritto nei blocchi di uscita
+class LoopPromoter : public LoadAndStorePromoter {
+public:
+  LoopPromoter(Value *Ptr, ArrayRef<const Instruction*> Insts, SSAUpdater &SSA,
+               ArrayRef<BasicBlock*> Exits, Align Alignment,
+               MemorySSAUpdater *MSSAU)
+      : LoadAndStorePromoter(Insts, SSA), Ptr(Ptr), Exits(Exits),
+        Alignment(Alignment), MSSAU(MSSAU) {}
+
+  void doExtraRewritesBeforeFinalDeletion() override {
+    for (BasicBlock *exit : Exits) {
+      Value *liveOut = SSA.GetValueInMiddleOfBlock(exit);
+      // il valore che esce dal loop passa da una PHI LCSSA
+      if (auto *def = dyn_cast<Instruction>(liveOut))
+        if (def->getParent() != exit) {
+          PHINode *PN = PHINode::Create(def->getType(), pred_size(exit),
+                                        def->getName() + ".lcssa", &exit->front());
+          for (BasicBlock *pred : predecessors(exit))
+            PN->addIncoming(def, pred);
+          liveOut = PN;
+        }
+      auto *store = new StoreInst(liveOut, Ptr, false, Alignment,
+                                  &*exit->getFirstInsertionPt());
+      outs() << "Store nell'uscita " << exit->getName() << ": " << *store << "\n";
+      if (MSSAU) {
+        MemoryAccess *access = MSSAU->createMemoryAccessInBB(
+            store, nullptr, exit, MemorySSA::Beginning);
+        MSSAU->insertDef(cast<MemoryDef>(access), true);
+      }
+    }
+  }
+
+  void instructionDeleted(Instruction *I) const override {
+    if (MSSAU)
+      MSSAU->removeMemoryAccess(I);
+  }
+
+private:
+  Value *Ptr;
+  ArrayRef<BasicBlock*> Exits;
+  Align Alignment;
+  MemorySSAUpdater *MSSAU;
+};
+
+// memoria di un'alloca il cui indirizzo non esce dalla funzione: chi
+// gestisce un'eccezione lanciata nel loop non può leggerla
+bool isLocalObject(Value *ptr) {
+  auto *AI = dyn_cast<AllocaInst>(getUnderlyingObject(ptr));
+  return AI && !PointerMayBeCaptured(AI, true, true);
+}
+
+// Promozione in registro degli accessi a una locazione invariante: se nel
+// loop nessun'altra istruzione legge o scrive la locazione, basta una load
+// nel preheader e una store in ogni uscita. Serve che:
+// - una delle store sia in un blocco che domina le uscite, altrimenti si
+//   aggiungerebbe una scrittura a cammini che non ne eseguivano;
+// - nessuna istruzione del loop possa lanciare un'eccezione, perché le
+//   store rimandate alle uscite andrebbero perse (salvo per un'alloca locale);
+// - uno degli accessi sia eseguito a ogni ingresso nel loop, o il puntatore
+//   sia dereferenziabile, perché la load nel preheader non causi un trap
+bool promoteMemory(Loop &loop, LoopState &state, BasicBlock *preheader,
+                   const SmallPtrSetImpl<BasicBlock*> &exitDominating) {
+  if (!loop.hasDedicatedExits())
+    return false;
+
+  SmallVector<Instruction*, 16> memInsts;
+  MapVector<Value*, SmallVector<Instruction*, 4>> groups;
+  for (BasicBlock *block : loop.blocks())
+    for (Instruction &I : *block) {
+      if (!I.mayReadOrWriteMemory())
+        continue;
+      memInsts.push_back(&I);
+      Value *ptr = getLoadStorePointerOperand(&I);
+      if (ptr && isOpInv(ptr, loop, state) &&
+          (isa<LoadInst>(I) ? cast<LoadInst>(I).isSimple()
+                            : cast<StoreInst>(I).isSimple()))
+        groups[ptr].push_back(&I);
+    }
+
+  SmallVector<BasicBlock*, 4> exits;
+  loop.getUniqueExitBlocks(exits);
+  const DataLayout &DL = preheader->getModule()->getDataLayout();
+  bool changed = false;
+
+  for (auto &group : groups) {
+    Value *ptr = group.first;
+    SmallVector<Instruction*, 4> &accesses = group.second;
+    Type *type = getLoadStoreType(accesses.front());
+
+    StoreInst *guaranteed = nullptr;
+    bool sameType = true;
+    for (Instruction *I : accesses) {
+      sameType &= getLoadStoreType(I) == type;
+      if (auto *store = dyn_cast<StoreInst>(I))
+        if (!guaranteed && exitDominating.count(store->getParent()))
+          guaranteed = store;
+    }
+    if (!guaranteed || !sameType)
+      continue;
+
+    MemoryLocation loc(ptr, LocationSize::precise(DL.getTypeStoreSize(type)));
+    bool isolated = all_of(memInsts, [&](Instruction *I) {
+      return is_contained(accesses, I) ||
+             !isModOrRefSet(state.LAR.AA.getModRefInfo(I, loc));
+    });
+    if (!isolated) {
+      outs() << *ptr << " - Non promossa: altri accessi alla stessa memoria\n";
+      continue;
+    }
+
+    if (state.SafetyInfo.anyBlockMayThrow() && !isLocalObject(ptr)) {
+      outs() << *ptr << " - Non promossa: il loop può lanciare eccezioni\n";
+      continue;
+    }
+
+    Align alignment = guaranteed->getAlign();
+    bool executed = any_of(accesses, [&](Instruction *I) {
+      return isGuaranteedToExecute(I, loop, state);
+    });
+    if (!executed &&
+        !isDereferenceableAndAlignedPointer(ptr, type, alignment, DL,
+                                            preheader->getTerminator(), nullptr,
+                                            &state.LAR.DT, &state.LAR.TLI)) {
+      outs() << *ptr << " - Non promossa: la load nel preheader può causare un trap\n";
+      continue;
+    }
+
+    outs() << "Locazione promossa in registro: " << *ptr << "\n";
+    SmallVector<PHINode*, 8> newPHIs;
+    SSAUpdater SSA(&newPHIs);
+    SmallVector<const Instruction*, 4> insts(accesses.begin(), accesses.end());
+    LoopPromoter promoter(ptr, insts, SSA, exits, alignment, state.MSSAU);
+
+    auto *load = new LoadInst(type, ptr, ptr->getName() + ".promoted", false,
+                              alignment, preheader->getTerminator());
+    if (state.MSSAU) {
+      MemoryAccess *access = state.MSSAU->createMemoryAccessInBB(
+          load, nullptr, preheader, MemorySSA::End);
+      state.MSSAU->insertUse(cast<MemoryUse>(access), true);
+    }
+    SSA.AddAvailableValue(preheader, load);
+    promoter.run(accesses);
+    erase_if(memInsts, [&](Instruction *I) { return is_contained(accesses, I); });
+
+    if (load->use_empty()) {
+      if (state.MSSAU)
+        state.MSSAU->removeMemoryAccess(load);
+      load->eraseFromParent();
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+// un'istruzione si può spostare nelle uscite se non ha effetti collaterali,
+// se la memoria che legge non cambia nel loop e se tutti i suoi usi sono PHI
+// LCSSA nei blocchi di uscita che ricevono solo lei
+bool canSink(Instruction &I, Loop &loop, LoopState &state) {
+  if (isa<PHINode>(I) || I.isTerminator() || isa<CallBase>(I) ||
+      isa<AllocaInst>(I) || I.isEHPad() || I.mayHaveSideEffects() ||
+      I.use_empty())
+    return false;
+
+  if (I.mayReadFromMemory()) {
+    auto *load = dyn_cast<LoadInst>(&I);
+    if (!load || !isMemoryInv(load, loop, state))
+      return false;
+  }
+
+  return all_of(I.users(), [&](User *U) {
+    auto *PN = dyn_cast<PHINode>(U);
+    return PN && !loop.contains(PN) &&
+           all_of(PN->incoming_values(), [&](Value *V) { return V == &I; });
+  });
+}
+
+// Sinking: le istruzioni usate solo dopo il loop vengono eseguite una volta
+// sola nei blocchi di uscita invece che a ogni iterazione. Il valore
+// calcolato nell'uscita è quello dell'ultima iterazione, perché gli operandi
+// dominano l'istruzione e non vengono ridefiniti prima dell'uscita. Con più
+// uscite l'istruzione viene duplicata, ma solo se costa poco
+bool sinkToExits(Loop &loop, LoopState &state) {
+  bool changed = false;
+  auto loopBlocks = loop.getBlocks();
+
+  // dal basso verso l'alto: dopo aver spostato un'istruzione i suoi operandi
+  // sono usati solo dalle nuove PHI LCSSA e possono seguirla
+  for (auto blockIt = loopBlocks.rbegin(); blockIt != loopBlocks.rend(); ++blockIt) {
+    BasicBlock *block = *blockIt;
+    for (Instruction &I : make_early_inc_range(reverse(*block))) {
+      if (!canSink(I, loop, state))
+        continue;
+
+      SmallVector<PHINode*, 4> users;
+      SmallPtrSet<BasicBlock*, 4> exits;
+      for (User *U : I.users()) {
+        users.push_back(cast<PHINode>(U));
+        exits.insert(cast<PHINode>(U)->getParent());
+      }
+
+      if (exits.size() > 1 &&
+          state.LAR.TTI.getInstructionCost(&I, TargetTransformInfo::TCK_SizeAndLatency) >
+              TargetTransformInfo::TCC_Basic) {
+        outs() << I << " - Non spostata: troppo costosa da duplicare in "
+               << exits.size() << " uscite\n";
+        continue;
+      }
+
+      // conviene solo se le uscite, tutte insieme, sono eseguite meno spesso
+      // del blocco
+      uint64_t blockFreq = getFrequency(block, state);
+      uint64_t exitsFreq = 0;
+      for (BasicBlock *exit : exits)
+        exitsFreq += getFrequency(exit, state);
+      if (blockFreq && exitsFreq > blockFreq) {
+        outs() << I << " - Non spostata: le uscite sono eseguite più spesso del blocco\n";
+        continue;
+      }
 
+      // come per l'hoisting, le copie di un'istruzione non sempre eseguita
+      // perdono metadati e attributi che implicano UB
+      bool guaranteed = isGuaranteedToExecute(&I, loop, state);
+      DenseMap<BasicBlock*, Instruction*> copies;
+      SmallVector<Instruction*, 2> created;
+      DenseMap<std::pair<BasicBlock*, Instruction*>, PHINode*> opPHIs;
+      for (PHINode *PN : users) {
+        BasicBlock *exit = PN->getParent();
+        Instruction *&copy = copies[exit];
+        if (!copy) {
+          copy = I.clone();
+          if (!guaranteed)
+            copy->dropUBImplyingAttrsAndMetadata();
+          copy->insertBefore(&*exit->getFirstInsertionPt());
+
+          // gli operandi definiti nel loop arrivano con nuove PHI LCSSA
+          for (Use &op : copy->operands()) {
+            auto *opInst = dyn_cast<Instruction>(op.get());
+            if (!opInst || !loop.contains(opInst))
+              continue;
+            PHINode *&opPN = opPHIs[{exit, opInst}];
+            if (!opPN) {
+              opPN = PHINode::Create(opInst->getType(), PN->getNumIncomingValues(),
+                                     opInst->getName() + ".lcssa", &exit->front());
+              for (BasicBlock *pred : PN->blocks())
+                opPN->addIncoming(opInst, pred);
+            }
+            op.set(opPN);
+          }
+
+          if (state.MSSAU && isa<LoadInst>(copy)) {
+            MemoryAccess *access = state.MSSAU->createMemoryAccessInBB(
+                copy, nullptr, exit, MemorySSA::Beginning);
+            state.MSSAU->insertUse(cast<MemoryUse>(access), true);
+          }
+          created.push_back(copy);
+        }
+        PN->replaceAllUsesWith(copy);
+        PN->eraseFromParent();
+      }
+
+      for (Instruction *copy : created) {
+        if (created.size() == 1)
+          copy->takeName(&I);
+        else
+          copy->setName(I.getName() + ".sunk");
+        outs() << "Istruzione spostata nell'uscita " << copy->getParent()->getName()
+               << ": " << *copy << "\n";
+      }
+      if (state.MSSAU)
+        state.MSSAU->removeMemoryAccess(&I);
+      I.eraseFromParent();
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+// Costanti per dividere per un divisore invariante con una moltiplicazione
+// (Granlund-Montgomery, come libdivide), calcolate una volta nel preheader.
+// Senza segno: q = (t + ((n - t) >> Shift1)) >> Shift2, con t = mulhu(M, n).
+// Con segno: q = ((n + mulhs(M, n)) >> Shift1) - segno(n), poi il segno del
+// divisore (Sign, 0 o -1) viene applicato con xor e sottrazione
+struct DivMagic {
+  Value *Multiplier;
+  Value *Shift1;
+  Value *Shift2;
+  Value *Sign;
+};
+
+// parte alta del prodotto, calcolato su 2N bit
+Value *mulHigh(IRBuilder<> &B, Value *X, Value *Y, bool isSigned) {
+  unsigned width = X->getType()->getIntegerBitWidth();
+  Type *wideTy = B.getIntNTy(2 * width);
+  Value *product = B.CreateMul(B.CreateIntCast(X, wideTy, isSigned),
+                               B.CreateIntCast(Y, wideTy, isSigned));
+  return B.CreateTrunc(B.CreateLShr(product, width), X->getType());
+}
+
+DivMagic computeMagic(IRBuilder<> &B, Value *divisor, bool isSigned) {
+  Type *type = divisor->getType();
+  unsigned width = type->getIntegerBitWidth();
+  Type *wideTy = B.getIntNTy(2 * width);
+  Value *one = ConstantInt::get(type, 1);
+
+  // con divisore 0 (o poison) la divisione originale non è definita: basta
+  // che il preheader non vada in trap
+  Value *d = B.CreateFreeze(divisor, divisor->getName() + ".fr");
+  d = B.CreateBinaryIntrinsic(Intrinsic::umax, d, one);
+  Value *abs = isSigned ? B.CreateSelect(B.CreateICmpSLT(d, ConstantInt::get(type, 0)),
+                                         B.CreateNeg(d), d)
+                        : d;
+
+  // l = ceil(log2 |d|)
+  Value *ctlz = B.CreateBinaryIntrinsic(Intrinsic::ctlz, B.CreateSub(abs, one),
+                                        B.getFalse());
+  Value *l = B.CreateSub(ConstantInt::get(type, width), ctlz);
+  Value *wideAbs = B.CreateZExt(abs, wideTy);
+  Value *wideOne = ConstantInt::get(wideTy, 1);
+
+  DivMagic magic;
+  if (!isSigned) {
+    // M = 2^N * (2^l - d) / d + 1
+    Value *num = B.CreateShl(B.CreateSub(B.CreateShl(wideOne, B.CreateZExt(l, wideTy)),
+                                         wideAbs),
+                             width);
+    magic.Multiplier = B.CreateTrunc(B.CreateAdd(B.CreateUDiv(num, wideAbs), wideOne),
+                                     type, "magic");
+    magic.Shift1 = B.CreateZExt(B.CreateICmpNE(l, ConstantInt::get(type, 0)), type);
+    magic.Shift2 = B.CreateSub(l, magic.Shift1);
+    magic.Sign = nullptr;
+  } else {
+    // l >= 1, M = 2^(N+l-1) / |d| + 1 - 2^N
+    l = B.CreateBinaryIntrinsic(Intrinsic::umax, l, one);
+    Value *exp = B.CreateZExt(B.CreateAdd(l, ConstantInt::get(type, width - 1)), wideTy);
+    magic.Multiplier = B.CreateTrunc(
+        B.CreateAdd(B.CreateUDiv(B.CreateShl(wideOne, exp), wideAbs), wideOne), type,
+        "magic");
+    magic.Shift1 = B.CreateSub(l, one);
+    magic.Shift2 = nullptr;
+    magic.Sign = B.CreateAShr(d, width - 1);
+  }
+  return magic;
+}
+
+// quoziente di n per il divisore descritto da magic
+Value *divideByMagic(IRBuilder<> &B, Value *n, const DivMagic &magic, bool isSigned) {
+  if (!isSigned) {
+    Value *t = mulHigh(B, magic.Multiplier, n, false);
+    Value *q = B.CreateAdd(t, B.CreateLShr(B.CreateSub(n, t), magic.Shift1));
+    return B.CreateLShr(q, magic.Shift2);
+  }
+  unsigned width = n->getType()->getIntegerBitWidth();
+  Value *q = B.CreateAdd(n, mulHigh(B, magic.Multiplier, n, true));
+  q = B.CreateSub(B.CreateAShr(q, magic.Shift1), B.CreateAShr(n, width - 1));
+  return B.CreateSub(B.CreateXor(q, magic.Sign), magic.Sign);
+}
+
+// Divisioni e resti per un divisore invariante ma non costante (le costanti
+// le gestisce già il backend): il costo di una divisione a ogni iterazione
+// diventa quello di una moltiplicazione e qualche shift. Le costanti vengono
+// calcolate una volta per divisore e segno, con una divisione su 2N bit:
+// conviene solo se il tipo a 2N bit è legale per il target (altrimenti
+// diventa una chiamata di libreria) e se il loop fa abbastanza iterazioni
+bool specializeDivisions(Loop &loop, LoopState &state, BasicBlock *preheader) {
+  SmallVector<BinaryOperator*, 4> divisions;
+  for (BasicBlock *block : loop.blocks())
+    for (Instruction &I : *block) {
+      auto *BO = dyn_cast<BinaryOperator>(&I);
+      if (!BO || !BO->isIntDivRem() || !BO->getType()->isIntegerTy() ||
+          BO->getType()->getIntegerBitWidth() > 64)
+        continue;
+      Value *divisor = BO->getOperand(1);
+      if (isa<Constant>(divisor) || !loop.isLoopInvariant(divisor))
+        continue;
+      Type *wideTy = IntegerType::get(BO->getContext(),
+                                      2 * BO->getType()->getIntegerBitWidth());
+      if (!state.LAR.TTI.isTypeLegal(wideTy)) {
+        outs() << *BO << " - Divisione non specializzata: " << *wideTy
+               << " non legale per il target\n";
+        continue;
+      }
+      divisions.push_back(BO);
+    }
+  if (divisions.empty())
+    return false;
+
+  // numero di iterazioni calcolabile e, se limitato da una costante, non
+  // troppo piccolo
+  ScalarEvolution &SE = state.LAR.SE;
+  unsigned maxTrips = SE.getSmallConstantMaxTripCount(&loop);
+  if (isa<SCEVCouldNotCompute>(SE.getBackedgeTakenCount(&loop)) ||
+      (maxTrips && maxTrips < MinDivisionTrips)) {
+    outs() << "Divisioni non specializzate: il loop fa poche iterazioni o un "
+              "numero non calcolabile\n";
+    return false;
+  }
+
+  std::map<std::pair<Value*, bool>, DivMagic> magics;
+  for (BinaryOperator *BO : divisions) {
+    unsigned opcode = BO->getOpcode();
+    bool isSigned = opcode == Instruction::SDiv || opcode == Instruction::SRem;
+    Value *divisor = BO->getOperand(1);
+
+    auto it = magics.find({divisor, isSigned});
+    if (it == magics.end()) {
+      IRBuilder<> PB(preheader->getTerminator());
+      it = magics.insert({{divisor, isSigned}, computeMagic(PB, divisor, isSigned)}).first;
+    }
+
+    IRBuilder<> B(BO);
+    Value *q = divideByMagic(B, BO->getOperand(0), it->second, isSigned);
+    Value *result = q;
+    if (opcode == Instruction::URem || opcode == Instruction::SRem)
+      result = B.CreateSub(BO->getOperand(0), B.CreateMul(q, divisor));
+
+    outs() << *BO << " - Divisione per invariante: moltiplicazione per "
+           << it->second.Multiplier->getName() << "\n";
+    result->takeName(BO);
+    BO->replaceAllUsesWith(result);
+    BO->eraseFromParent();
+  }
+  return true;
+}
+
+// blocchi che dominano tutte le uscite: sono quelli sul cammino del
+// dominator tree dall'header al dominatore comune più vicino delle uscite,
+// quindi basta risalire da quest'ultimo. Un loop senza uscite non ne ha da
+// dominare: vanno bene tutti i blocchi
+SmallPtrSet<BasicBlock*, 8> findExitDominating(Loop &loop, DominatorTree &DT,
+                                               ArrayRef<BasicBlock*> exits) {
+  SmallPtrSet<BasicBlock*, 8> result;
+  if (exits.empty()) {
+    result.insert(loop.block_begin(), loop.block_end());
+    return result;
+  }
+
+  BasicBlock *common = exits.front();
+  for (BasicBlock *exit : exits.drop_front())
+    common = DT.findNearestCommonDominator(common, exit);
+
+  for (DomTreeNode *node = DT.getNode(common); node; node = node->getIDom()) {
+    if (loop.contains(node->getBlock()))
+      result.insert(node->getBlock());
+    if (node->getBlock() == loop.getHeader())
+      break;
+  }
+  return result;
+}
+
+// blocchi del loop in preordine sul dominator tree: le definizioni vengono
+// visitate prima degli usi, e un invariante trovato in un blocco rende
+// invarianti anche le istruzioni che lo usano nei blocchi dominati
+std::vector<BasicBlock*> dominatorOrder(Loop &loop, DominatorTree &DT) {
+  std::vector<BasicBlock*> order;
+  SmallVector<DomTreeNode*, 16> stack {DT.getNode(loop.getHeader())};
+  while (!stack.empty()) {
+    DomTreeNode *node = stack.pop_back_val();
+    order.push_back(node->getBlock());
+    // i blocchi del loop sono dominati solo da blocchi del loop o
+    // dall'esterno: i sottoalberi fuori dal loop non servono
+    for (DomTreeNode *child : reverse(node->children()))
+      if (loop.contains(child->getBlock()))
+        stack.push_back(child);
+  }
+  return order;
+}
+
+bool runOnLoop(Loop &loop, LoopStandardAnalysisResults &LAR,
+               MemorySSAUpdater *MSSAU,
+               std::optional<RegisterPressure> &pressure) {
+
+  outs() << "Loop: " << loop.getHeader()->getName() << " (profondità "
+         << loop.getLoopDepth() << ")\n";
+  LoopState state(LAR, MSSAU);
+
+  // controllo e visualizzazione preheader: manca solo se non è stato
+  // possibile inserirlo (ad esempio archi da indirectbr)
+  BasicBlock* preheader = loop.getLoopPreheader();
   if (!preheader) {
+    outs() << "Loop senza preheader\n";
     return false;
   }
+  preheader->print(outs());
 
   SmallVector<BasicBlock*> vec {};
-  loop.getExitBlocks(vec);
-  BasicBlock * exitBlock = loop.getUniqueExitBlock();
-  exitBlock->print(outs());
+  loop.getUniqueExitBlocks(vec);
+  for (BasicBlock *exitBlock : vec)
+    outs() << "Exit Block: " << exitBlock->getName() << "\n";
   llvm::DominatorTree &DT = LAR.DT;
   DT.print(outs());
 
   BasicBlock *BB = (DT.getRootNode())->getBlock();
   BB->print(outs());
 
-  auto loopBlocks = loop.getBlocks();
-  for (auto &block : loopBlocks) {
-      bool dominateExits = true;
-      block->print(outs());
+  // se il loop fa almeno un giro completo anche le istruzioni nei blocchi
+  // che dominano il latch vengono sicuramente eseguite
+  state.SafetyInfo.computeLoopSafetyInfo(&loop);
+  state.RunsOnce = runsAtLeastOnce(loop, state);
+  outs() << "Almeno un'iterazione completa: " << state.RunsOnce << "\n";
 
-      for(auto it = vec.begin(); it != vec.end(); ++it) {
-          BasicBlock *exitBlock = *it;
-          outs() << "Exit Block: " << exitBlock->getName() << "\n\n";
-          if(!DT.dominates(block, exitBlock))
-              dominateExits = false;
-      }
-      
-      outs() << block->getName() << " - Dominate Exit: " << dominateExits << "\n";
+  SmallPtrSet<BasicBlock*, 8> exitDominating = findExitDominating(loop, DT, vec);
+  for (BasicBlock *block : dominatorOrder(loop, DT)) {
+      block->print(outs());
+      outs() << block->getName() << " - Dominate Exit: "
+             << exitDominating.count(block) << "\n";
 
-      if (dominateExits) 
-        findInstInv(*block, loop);
+      findInstInv(*block, loop, state, preheader);
   }
 
-  for (auto &I : ToMove) {
+  limitPressure(loop, LAR.TTI, state, pressure);
+
+  for (auto &I : state.ToMove) {
     outs () << "Instruction to move: " << *I << "\n";
+    // un'istruzione che il loop poteva non eseguire perde metadati e
+    // attributi (!noundef, !range, nonnull, ...) che renderebbero UB i
+    // cammini su cui prima non veniva calcolata
+    if (!isGuaranteedToExecute(I, loop, state))
+      I->dropUBImplyingAttrsAndMetadata();
     I->moveBefore(preheader->getTerminator());
+    if (MSSAU)
+      if (MemoryUseOrDef *access = MSSAU->getMemorySSA()->getMemoryAccess(I))
+        MSSAU->moveToPlace(access, preheader, MemorySSA::BeforeTerminator);
   }
 
+  bool promoted = promoteMemory(loop, state, preheader, exitDominating);
+  bool sunk = sinkToExits(loop, state);
+  bool specialized = specializeDivisions(loop, state, preheader);
+
   preheader->print(outs());
 
+  return !state.ToMove.empty() || promoted || sunk || specialized;
+}
+
+// primo branch condizionato del loop con una condizione invariante non
+// costante (quelle costanti le semplifica SimplifyCFG)
+BranchInst *findInvariantBranch(Loop &loop) {
+  for (BasicBlock *block : loop.blocks()) {
+    auto *BI = dyn_cast<BranchInst>(block->getTerminator());
+    if (BI && BI->isConditional() && !isa<Constant>(BI->getCondition()) &&
+        BI->getSuccessor(0) != BI->getSuccessor(1) &&
+        loop.isLoopInvariant(BI->getCondition()))
+      return BI;
+  }
+  return nullptr;
+}
+
+// Unswitching: il loop viene duplicato dietro un unico test della condizione
+// nel vecchio preheader. Nell'originale il branch diventa "sempre vero",
+// nella copia "sempre falso"; gli archi restano, quindi la struttura dei
+// loop non cambia, e i rami morti vengono tolti da SimplifyCFG. Le uscite
+// ricevono i valori di entrambe le versioni tramite le PHI LCSSA
+bool unswitchLoop(Loop &loop, LoopStandardAnalysisResults &LAR,
+                  MemorySSAUpdater *MSSAU, LPMUpdater &LU) {
+  BasicBlock *preheader = loop.getLoopPreheader();
+  if (!preheader || !loop.hasDedicatedExits() ||
+      !loop.isRecursivelyLCSSAForm(LAR.DT, LAR.LI))
+    return false;
+
+  BranchInst *BI = findInvariantBranch(loop);
+  if (!BI)
+    return false;
+
+  unsigned size = 0;
+  for (BasicBlock *block : loop.blocks())
+    size += block->size();
+  unsigned budget = UnswitchBudget / LAR.LI.getTopLevelLoops().size();
+  if (size > budget) {
+    outs() << *BI << " - Unswitching non fatto: " << size
+           << " istruzioni, limite " << budget << "\n";
+    return false;
+  }
+
+  Value *cond = BI->getCondition();
+  LLVMContext &ctx = cond->getContext();
+
+  // nuovo preheader vuoto: il vecchio diventa il blocco del test
+  BasicBlock *newPreheader = SplitEdge(preheader, loop.getHeader(), &LAR.DT,
+                                       &LAR.LI, MSSAU);
+  SmallVector<BasicBlock*, 4> exits;
+  loop.getUniqueExitBlocks(exits);
+
+  // blocchi fuori dal loop dominati direttamente da un blocco del loop: le
+  // uscite, ma anche ad esempio un blocco raggiunto da più uscite
+  SmallVector<BasicBlock*, 8> dominatedOutside;
+  for (BasicBlock *block : loop.blocks())
+    for (DomTreeNode *child : LAR.DT.getNode(block)->children())
+      if (!loop.contains(child->getBlock()))
+        dominatedOutside.push_back(child->getBlock());
+
+  ValueToValueMapTy VMap;
+  SmallVector<BasicBlock*, 16> newBlocks;
+  Loop *newLoop = cloneLoopWithPreheader(newPreheader, preheader, &loop, VMap,
+                                         ".us", &LAR.LI, &LAR.DT, newBlocks);
+  remapInstructionsInBlocks(newBlocks, VMap);
+  auto *clonedPreheader = cast<BasicBlock>(VMap[newPreheader]);
+
+  // le uscite hanno ora come predecessori anche i blocchi della copia
+  for (BasicBlock *exit : exits)
+    for (PHINode &PN : exit->phis())
+      for (unsigned i = 0, e = PN.getNumIncomingValues(); i != e; ++i) {
+        Value *value = PN.getIncomingValue(i);
+        if (Value *mapped = VMap.lookup(value))
+          value = mapped;
+        PN.addIncoming(value, cast<BasicBlock>(VMap[PN.getIncomingBlock(i)]));
+      }
+
+  // ci si arriva da entrambe le versioni, che si separano nel blocco del
+  // test: è lui il nuovo dominatore immediato
+  for (BasicBlock *block : dominatedOutside)
+    LAR.DT.changeImmediateDominator(block, preheader);
+
+  // una condizione poison nel preheader renderebbe indefinito anche un loop
+  // che non valutava mai il branch
+  Instruction *oldTerm = preheader->getTerminator();
+  Value *test = cond;
+  if (!isGuaranteedNotToBeUndefOrPoison(cond))
+    test = new FreezeInst(cond, cond->getName() + ".fr", oldTerm);
+  BranchInst::Create(newPreheader, clonedPreheader, test, oldTerm);
+  oldTerm->eraseFromParent();
+
+  BI->setCondition(ConstantInt::getTrue(ctx));
+  cast<BranchInst>(VMap[BI])->setCondition(ConstantInt::getFalse(ctx));
+
+  if (MSSAU) {
+    LoopBlocksRPO blocksRPO(&loop);
+    blocksRPO.perform(&LAR.LI);
+    MSSAU->updateForClonedLoop(blocksRPO, exits, VMap);
+    MSSAU->updateExitBlocksForClonedLoop(exits, VMap, LAR.DT);
+    MSSAU->applyInsertUpdates({{DominatorTree::Insert, preheader, clonedPreheader}},
+                              LAR.DT);
+  }
+  LAR.SE.forgetLoop(&loop);
+
+  // le uscite ora sono condivise: ogni versione riceve le proprie, così
+  // entrambe restano in forma canonica e possono essere visitate di nuovo
+  formDedicatedExitBlocks(&loop, &LAR.DT, &LAR.LI, MSSAU, true);
+  formDedicatedExitBlocks(newLoop, &LAR.DT, &LAR.LI, MSSAU, true);
+
+  outs() << "Unswitching su " << *cond << ": copia " << newLoop->getHeader()->getName()
+         << " per la condizione falsa\n";
+  // entrambe le versioni vengono rivisitate per gli altri branch invarianti
+  LU.addSiblingLoops({newLoop});
+  LU.revisitCurrentLoop();
   return true;
 }
 
+// Forma canonica del nido: LCSSA, un preheader e uscite dedicate per ogni
+// loop. Il pass manager la costruisce prima dei passi sui loop, ma un passo
+// precedente della stessa pipeline può averla persa. I blocchi aggiunti non
+// creano nuovi loop, quindi basta aggiornare dominator tree, LoopInfo e
+// MemorySSA; i loop con più latch restano tali
+bool canonicalizeLoopNest(Loop &loop, LoopStandardAnalysisResults &LAR,
+                          MemorySSAUpdater *MSSAU) {
+  bool changed = false;
+  if (!loop.isRecursivelyLCSSAForm(LAR.DT, LAR.LI)) {
+    outs() << "Loop " << loop.getHeader()->getName() << " portato in forma LCSSA\n";
+    changed |= formLCSSARecursively(loop, LAR.DT, &LAR.LI, &LAR.SE);
+  }
 
-PreservedAnalyses LoopWalk::run(Loop &L, LoopAnalysisManager &LAM, LoopStandardAnalysisResults &LAR, LPMUpdater &LU) {
+  for (Loop *subLoop : loop.getLoopsInPreorder()) {
+    if (!subLoop->getLoopPreheader() &&
+        InsertPreheaderForLoop(subLoop, &LAR.DT, &LAR.LI, MSSAU, true)) {
+      outs() << "Preheader inserito per il loop "
+             << subLoop->getHeader()->getName() << "\n";
+      changed = true;
+    }
+    if (!subLoop->hasDedicatedExits() &&
+        formDedicatedExitBlocks(subLoop, &LAR.DT, &LAR.LI, MSSAU, true)) {
+      outs() << "Uscite dedicate per il loop "
+             << subLoop->getHeader()->getName() << "\n";
+      changed = true;
+    }
+  }
 
-  if (!runOnLoop(L,LAM,LAR,LU)){
-    return PreservedAnalyses::none();
+  if (changed)
+    LAR.SE.forgetTopmostLoop(&loop);
+  return changed;
+}
+
+// visita del nido dall'interno verso l'esterno: quello che un sottoloop
+// sposta nel suo preheader fa parte del loop padre e viene riconsiderato
+// subito, così un'espressione invariante in tutto il nido arriva al
+// preheader del loop più esterno in una sola esecuzione del passo
+bool runOnLoopNest(Loop &loop, LoopStandardAnalysisResults &LAR,
+                   MemorySSAUpdater *MSSAU,
+                   std::optional<RegisterPressure> &pressure) {
+  bool changed = false;
+  for (Loop *subLoop : loop.getSubLoops())
+    changed |= runOnLoopNest(*subLoop, LAR, MSSAU, pressure);
+
+  // le istruzioni spostate cambiano la liveness: la pressione va ricalcolata
+  if (runOnLoop(loop, LAR, MSSAU, pressure)) {
+    pressure.reset();
+    changed = true;
   }
-  
-  return PreservedAnalyses::all();
+  return changed;
+}
+
+
+PreservedAnalyses LoopWalk::run(Loop &L, LoopAnalysisManager &LAM, LoopStandardAnalysisResults &LAR, LPMUpdater &LU) {
+
+  // i sottoloop vengono visitati insieme al loop più esterno del nido
+  if (L.getParentLoop())
+    return PreservedAnalyses::all();
+
+  std::optional<MemorySSAUpdater> MSSAU;
+  if (LAR.MSSA)
+    MSSAU.emplace(LAR.MSSA);
+
+  // calcolata alla prima richiesta e riusata da tutto il nido
+  std::optional<RegisterPressure> pressure;
+  bool changed = canonicalizeLoopNest(L, LAR, MSSAU ? &*MSSAU : nullptr);
+  changed |= runOnLoopNest(L, LAR, MSSAU ? &*MSSAU : nullptr, pressure);
+  // dopo lo spostamento degli invarianti, così la copia non li duplica
+  changed |= unswitchLoop(L, LAR, MSSAU ? &*MSSAU : nullptr, LU);
+  if (!changed)
+    return PreservedAnalyses::all();
+
+  // LoopInfo, dominator tree, ScalarEvolution e MemorySSA sono aggiornati
+  // anche dopo l'unswitching
+  PreservedAnalyses PA = getLoopPassPreservedAnalyses();
+  if (LAR.MSSA)
+    PA.preserve<MemorySSAAnalysis>();
+  return PA;
 }
 
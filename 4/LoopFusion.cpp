@@ -5,6 +5,9 @@
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
 #include "llvm/IR/TypedPointerType.h"
+#include "llvm/Analysis/DomTreeUpdater.h"
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include <map>
 
 // Memorizzazione coppie di loop adiacenti
 void pair(llvm::Loop* &L1, llvm::Loop* &L2, std::set<std::pair<llvm::Loop*, llvm::Loop*>> &set) {
@@ -119,6 +122,64 @@ bool negDependencies(std::pair<llvm::Loop*, llvm::Loop*> loop) {
 }
 
 
+// Stima della pressione sui registri del loop fuso: nel corpo di ciascun loop
+// restano vivi anche i valori che attraversano l'altro
+bool registerPressure(std::pair<llvm::Loop*, llvm::Loop*> loop, const llvm::RegisterPressure &RP) {
+  llvm::BasicBlock *header1 = loop.first->getHeader();
+  llvm::BasicBlock *header2 = loop.second->getHeader();
+
+  for (unsigned ClassID : RP.getRegisterClasses()) {
+    unsigned fused = std::max(
+        RP.getMaxPressure(loop.first->getBlocks(), ClassID) + RP.getLiveIn(header2, ClassID),
+        RP.getMaxPressure(loop.second->getBlocks(), ClassID) + RP.getLiveIn(header1, ClassID));
+
+    if (fused > RP.getNumRegisters(ClassID)) {
+      llvm::outs() << "\nLoop non fondibili: pressione stimata " << fused
+                   << " oltre i " << RP.getNumRegisters(ClassID) << " registri disponibili\n";
+      return 0;
+    }
+  }
+  return 1;
+}
+
+
+// Successori dei blocchi coinvolti nella fusione, prima delle modifiche al CFG
+std::map<llvm::BasicBlock*, std::set<llvm::BasicBlock*>> cfgSnapshot(std::pair<llvm::Loop*, llvm::Loop*> loop) {
+  std::map<llvm::BasicBlock*, std::set<llvm::BasicBlock*>> snapshot {};
+
+  for (llvm::Loop *L : {loop.first, loop.second}) {
+    for (auto &BB : L->getBlocks())
+      snapshot[BB].insert(llvm::succ_begin(BB), llvm::succ_end(BB));
+    if (L->isGuarded()) {
+      auto guard = L->getLoopGuardBranch()->getParent();
+      snapshot[guard].insert(llvm::succ_begin(guard), llvm::succ_end(guard));
+    }
+  }
+  return snapshot;
+}
+
+// Aggiornamento incrementale di dominator e post-dominator tree con gli archi
+// aggiunti e rimossi dalla fusione, invece di ricalcolarli da zero
+void updateDominators(std::map<llvm::BasicBlock*, std::set<llvm::BasicBlock*>> &snapshot, llvm::DominatorTree &DT, llvm::PostDominatorTree &PDT) {
+  std::vector<llvm::DominatorTree::UpdateType> updates {};
+
+  for (auto &entry : snapshot) {
+    std::set<llvm::BasicBlock*> newSuccs(llvm::succ_begin(entry.first), llvm::succ_end(entry.first));
+
+    for (auto succ : entry.second)
+      if (!newSuccs.count(succ))
+        updates.push_back({llvm::DominatorTree::Delete, entry.first, succ});
+    for (auto succ : newSuccs)
+      if (!entry.second.count(succ))
+        updates.push_back({llvm::DominatorTree::Insert, entry.first, succ});
+  }
+
+  llvm::DomTreeUpdater DTU(&DT, &PDT, llvm::DomTreeUpdater::UpdateStrategy::Eager);
+  DTU.applyUpdates(updates);
+  llvm::outs() << "Dominator tree aggiornati con " << updates.size() << " modifiche agli archi\n";
+}
+
+
 // Fusione dei loop
 void loopFusion(llvm::Loop* &L1, llvm::Loop* &L2){
  
@@ -196,6 +257,8 @@ llvm::PreservedAnalyses llvm::LoopFusion::run(Function &F, FunctionAnalysisManag
   llvm::DominatorTree &DT = AM.getResult<DominatorTreeAnalysis>(F);
   llvm::PostDominatorTree &PDT = AM.getResult<PostDominatorTreeAnalysis>(F);
   llvm::ScalarEvolution &SE = AM.getResult<ScalarEvolutionAnalysis>(F);
+  llvm::TargetTransformInfo &TTI = AM.getResult<TargetIRAnalysis>(F);
+  llvm::RegisterPressure RP(F, TTI);
   
   // Set con coppie di loop adiacenti
   std::set<std::pair<llvm::Loop*, llvm::Loop*>> adjacentLoops {};
@@ -208,9 +271,13 @@ llvm::PreservedAnalyses llvm::LoopFusion::run(Function &F, FunctionAnalysisManag
     if (!checkEquivalence(loop, DT, PDT)) continue;
     if (!TripCount(loop, SE)) continue;
     if (!negDependencies(loop)) continue;
+    if (!registerPressure(loop, RP)) continue;
 
     llvm::outs() << "\nI loop possono essere fusi\n";
+    auto snapshot = cfgSnapshot(loop);
     loopFusion(loop.first, loop.second);
+    updateDominators(snapshot, DT, PDT);
+    RP = llvm::RegisterPressure(F, TTI);
 
     modified = 1;
   }
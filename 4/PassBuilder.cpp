@@ -258,6 +258,18 @@
 #include "llvm/Transforms/Utils/LocalOpts.h"
 #include "llvm/Transforms/Utils/LoopWalk.h"
 #include "llvm/Transforms/Utils/LoopFusion.h"
+#include "llvm/Transforms/Utils/DataflowAnalysis.h"
+#include "llvm/Transforms/Utils/SparseConstProp.h"
+#include "llvm/Transforms/Utils/CodeHoisting.h"
+#include "llvm/Transforms/Utils/LazyCodeMotion.h"
+#include "llvm/Transforms/Utils/DominatorBench.h"
+#include "llvm/Transforms/Utils/RegisterPressure.h"
+#include "llvm/Transforms/Utils/RangeAnalysis.h"
+#include "llvm/Transforms/Utils/IPConstProp.h"
+#include "llvm/Transforms/Utils/AggressiveDCE.h"
+#include "llvm/Transforms/Utils/IVStrengthReduce.h"
+#include "llvm/Transforms/Utils/DeadLoopElim.h"
+#include "llvm/Transforms/Utils/LoopIdioms.h"
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
 #include "llvm/Transforms/Utils/UnifyLoopExits.h"
 #include "llvm/Transforms/Vectorize/LoadStoreVectorizer.h"
@@ -1648,7 +1660,8 @@ Error PassBuilder::parseFunctionPass(FunctionPassManager &FPM,
       // Add the nested pass manager with the appropriate adaptor.
       bool UseMemorySSA = (Name == "loop-mssa");
       bool UseBFI = llvm::any_of(InnerPipeline, [](auto Pipeline) {
-        return Pipeline.Name.contains("simple-loop-unswitch");
+        return Pipeline.Name.contains("simple-loop-unswitch") ||
+               Pipeline.Name == "loopwalk";
       });
       bool UseBPI = llvm::any_of(InnerPipeline, [](auto Pipeline) {
         return Pipeline.Name == "loop-predication";